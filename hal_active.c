@@ -0,0 +1,130 @@
+/**************************************************************************************************
+  Filename:       hal_active.c
+
+  Revision:       20230128
+
+  Description:    Active CPU time accounting of HAL drivers. Sections are timed with the
+                  32768 Hz sleep timer, so short sections are measured statistically:
+                  quantization error averages out over many sections.
+
+**************************************************************************************************/
+
+/**************************************************************************************************
+ *                                            INCLUDES
+ **************************************************************************************************/
+#include "hal_mcu.h"
+#include "hal_defs.h"
+#include "hal_types.h"
+#include "hal_active.h"
+#include "OSAL.h"
+
+/**************************************************************************************************
+ *                                              MACROS
+ **************************************************************************************************/
+
+/* us per sleep timer tick = 1000000 / 32768 = 15625 / 512 */
+#define HAL_ACTIVE_US_NUM   15625UL
+#define HAL_ACTIVE_US_SHIFT 9
+
+/**************************************************************************************************
+ *                                        LOCAL VARIABLES
+ **************************************************************************************************/
+
+#if HAL_ACTIVE_STATS
+static halActiveStats_t halActiveStats[HAL_ACTIVE_COUNT];
+static uint16 halActiveFrac[HAL_ACTIVE_COUNT]; // 1/512 us remainder
+#endif
+
+/**************************************************************************************************
+ *                                        FUNCTIONS - API
+ **************************************************************************************************/
+
+#if HAL_ACTIVE_STATS
+/**************************************************************************************************
+ * @fn      halActiveNow
+ *
+ * @brief   Read low 16 bits of sleep timer
+ *
+ * @param   None
+ *
+ * @return  sleep timer ticks
+ **************************************************************************************************/
+uint16 halActiveNow(void)
+{
+    halIntState_t intState;
+    uint16 t;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    t = ST0; // ST0 read latches ST1
+    t |= (uint16)ST1 << 8;
+    HAL_EXIT_CRITICAL_SECTION(intState);
+
+    return t;
+}
+
+/**************************************************************************************************
+ * @fn      halActiveAdd
+ *
+ * @brief   Account section started at given time, safe in ISR
+ *
+ * @param   sub - HAL_ACTIVE_* subsystem
+ *          start - halActiveNow() at section start
+ *
+ * @return  None
+ **************************************************************************************************/
+void halActiveAdd(uint8 sub, uint16 start)
+{
+    halIntState_t intState;
+    uint32 frac;
+    uint16 ticks = halActiveNow() - start;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    frac = halActiveFrac[sub] + ticks * HAL_ACTIVE_US_NUM;
+    halActiveStats[sub].us += frac >> HAL_ACTIVE_US_SHIFT;
+    halActiveFrac[sub] = (uint16)frac & ((1 << HAL_ACTIVE_US_SHIFT) - 1);
+    halActiveStats[sub].count++;
+    HAL_EXIT_CRITICAL_SECTION(intState);
+}
+#endif /* HAL_ACTIVE_STATS */
+
+/**************************************************************************************************
+ * @fn      HalActiveStats
+ *
+ * @brief   Read active time of subsystem
+ *
+ * @param   sub - HAL_ACTIVE_* subsystem
+ *          stats - target, zeroed without HAL_ACTIVE_STATS, NULL is ignored
+ *          reset - TRUE to restart accounting
+ *
+ * @return  None
+ **************************************************************************************************/
+void HalActiveStats(uint8 sub, halActiveStats_t *stats, bool reset)
+{
+#if HAL_ACTIVE_STATS
+    halIntState_t intState;
+#endif
+
+    if (stats == NULL)
+        return;
+
+#if HAL_ACTIVE_STATS
+    if (sub >= HAL_ACTIVE_COUNT)
+    {
+        osal_memset(stats, 0, sizeof(halActiveStats_t));
+        return;
+    }
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    *stats = halActiveStats[sub];
+    if (reset)
+    {
+        osal_memset(&halActiveStats[sub], 0, sizeof(halActiveStats_t));
+        halActiveFrac[sub] = 0;
+    }
+    HAL_EXIT_CRITICAL_SECTION(intState);
+#else
+    (void)sub;
+    (void)reset;
+    osal_memset(stats, 0, sizeof(halActiveStats_t));
+#endif
+}
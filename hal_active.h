@@ -0,0 +1,50 @@
+/**************************************************************************************************
+  Filename:       hal_active.h
+
+  Revision:       20230128
+
+  Description:    Active CPU time accounting of HAL drivers
+
+**************************************************************************************************/
+
+#ifndef HAL_ACTIVE_H
+#define HAL_ACTIVE_H
+
+#include "hal_types.h"
+
+#ifndef HAL_ACTIVE_STATS
+#define HAL_ACTIVE_STATS FALSE
+#endif
+
+/* Accounted subsystems */
+#define HAL_ACTIVE_I2C       0 // HalI2CStart() .. HalI2CStop(), including stretch waits
+#define HAL_ACTIVE_KEY_ISR   1 // key port ISRs
+#define HAL_ACTIVE_KEY_POLL  2 // HalKeyPoll()
+#define HAL_ACTIVE_KEY_SLEEP 3 // HalKeyEnterSleep(), HalKeyExitSleep()
+#define HAL_ACTIVE_COUNT     4
+
+typedef struct
+{
+    uint32 us;    // cumulative active time, us
+    uint32 count; // number of accounted sections
+} halActiveStats_t;
+
+#if HAL_ACTIVE_STATS
+/* Section start, sleep timer ticks */
+#define HAL_ACTIVE_BEGIN(start)     uint16 start = halActiveNow()
+/* Section end, adds elapsed time to subsystem */
+#define HAL_ACTIVE_END(sub, start)  halActiveAdd(sub, start)
+
+extern uint16 halActiveNow(void);
+extern void halActiveAdd(uint8 sub, uint16 start);
+#else
+#define HAL_ACTIVE_BEGIN(start)
+#define HAL_ACTIVE_END(sub, start)
+#endif
+
+/*
+ * Read active time of subsystem, optionally resetting it
+ */
+extern void HalActiveStats(uint8 sub, halActiveStats_t *stats, bool reset);
+
+#endif /* HAL_ACTIVE_H */
@@ -10,6 +10,17 @@
 #ifndef HAL_GPIO_DEFS_H
 #define HAL_GPIO_DEFS_H
 
+#include "hal_types.h"
+
+// GPIO transition trace, see hal_trace.h
+#ifndef HAL_TRACE
+#define HAL_TRACE FALSE
+#endif
+
+#if HAL_TRACE
+#include "hal_trace.h"
+#endif
+
 // General I/O definitions
 #define IO_GIO 0 // General purpose I/O
 #define IO_PER 1 // Peripheral function
@@ -23,10 +34,29 @@
 /* I/O PORT CONFIGURATION */
 #define IO_REG1(port, reg) P##port##reg
 #define IO_PIN1(port, pin) P##port##_##pin
+#define IO_PORT1(port) P##port
 #define IO_DIR(port) IO_REG1(port, DIR)
 #define IO_INP(port) IO_REG1(port, INP)
 #define IO_SEL(port) IO_REG1(port, SEL)
+#define IO_IEN(port) IO_REG1(port, IEN)
+#define IO_IFG(port) IO_REG1(port, IFG)
+#define IO_IF(port) IO_REG1(port, IF)
 #define IO_PIN(port, pin) IO_PIN1(port, pin)
+#define IO_PORT(port) IO_PORT1(port)
+
+// PICTL edge select bit of port pin, set for falling edge
+#define IO_EDGE_BIT(port, pin) ((port) == 0 ? 0x01 : (port) == 2 ? 0x08 : (pin) < 4 ? 0x02 : 0x04)
+
+// Record sampled level of pins, e.g. in port ISR
+// Record level implied by direction change of open drain pins, driven low or released
+// high, the pin itself follows only after the bus rise time
+#if HAL_TRACE
+#define IO_TRACE(port, mask) HAL_TRACE_RECORD(port, mask, IO_PORT(port) & (mask))
+#define IO_TRACE_DIR(port, mask, dir) HAL_TRACE_RECORD(port, mask, (dir) == IO_OUT ? 0 : (mask))
+#else
+#define IO_TRACE(port, mask)
+#define IO_TRACE_DIR(port, mask, dir)
+#endif
 
 #define IO_DIR_PORT_PIN(port, pin, dir)                   \
     st(                                                   \
@@ -34,6 +64,7 @@
             IO_DIR(port) |= BV(pin);                      \
         else                                              \
             IO_DIR(port) &= ~BV(pin);                     \
+        IO_TRACE_DIR(port, BV(pin), dir);                 \
     )
 
 #define IO_FUNC_PORT_PIN(port, pin, func)                 \
@@ -70,4 +101,63 @@
             P2INP &= ~BV(port + 5);                       \
     )
 
+/* MASK BASED PORT CONFIGURATION, one read-modify-write per register */
+#define IO_P2SEL_MASK(mask) (((mask) & 0x01) | (((mask) >> 2) & 0x06)) // P2_0, P2_3, P2_4
+#define IO_SEL_MASK(port, mask) ((port) < 2 ? (mask) : IO_P2SEL_MASK(mask))
+#define IO_INP_MASK(port, mask) ((port) < 2 ? (mask) : ((mask) & 0x1F)) // P2INP[7:5] are pull bits
+
+#define IO_SET_MASK(reg, mask, set)                       \
+    st(                                                   \
+        if (set)                                          \
+            reg |= (mask);                                \
+        else                                              \
+            reg &= ~(mask);                               \
+    )
+
+#define IO_DIR_PORT_MASK(port, mask, dir)                 \
+    st(                                                   \
+        IO_SET_MASK(IO_DIR(port), mask, dir == IO_OUT);   \
+        IO_TRACE_DIR(port, mask, dir);                    \
+    )
+
+#define IO_FUNC_PORT_MASK(port, mask, func)               \
+    IO_SET_MASK(IO_SEL(port), IO_SEL_MASK(port, mask), func == IO_PER)
+
+#define IO_IMODE_PORT_MASK(port, mask, mode)              \
+    IO_SET_MASK(IO_INP(port), IO_INP_MASK(port, mask), mode == IO_TRI)
+
+#define IO_CFG_PORT_MASK(port, mask, func, dir, mode)     \
+    st(                                                   \
+        IO_FUNC_PORT_MASK(port, mask, func);              \
+        IO_DIR_PORT_MASK(port, mask, dir);                \
+        IO_IMODE_PORT_MASK(port, mask, mode);             \
+    )
+
+/* BOARD PIN TABLE, whole register values written without read-back */
+typedef struct
+{
+    uint8 out; // Px output latch
+    uint8 sel; // PxSEL
+    uint8 dir; // PxDIR
+    uint8 inp; // PxINP, P2INP includes pull direction of all ports
+} ioPortCfg_t;
+
+#define IO_PUD_BITS(p0, p1, p2) (((p0) << 5) | ((p1) << 6) | ((p2) << 7))
+
+#define IO_PORT_CFG_APPLY1(port, cfg)                     \
+    st(                                                   \
+        P##port = (cfg).out;                              \
+        P##port##SEL = (cfg).sel;                         \
+        P##port##DIR = (cfg).dir;                         \
+        P##port##INP = (cfg).inp;                         \
+    )
+
+// cfg - const ioPortCfg_t[3], e.g. restore after PM3 or reset
+#define IO_BOARD_CFG_APPLY(cfg)                           \
+    st(                                                   \
+        IO_PORT_CFG_APPLY1(0, (cfg)[0]);                  \
+        IO_PORT_CFG_APPLY1(1, (cfg)[1]);                  \
+        IO_PORT_CFG_APPLY1(2, (cfg)[2]);                  \
+    )
+
 #endif /* HAL_GPIO_DEFS_H */
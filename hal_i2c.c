@@ -11,6 +11,17 @@
 #include "hal_gpio_defs.h"
 #include "hal_i2c.h"
 #include "OnBoard.h" // MicroWait()
+#include "OSAL.h"
+#include "hal_active.h"
+
+#if !defined HAL_I2C_DMA               // DMA paced transmit, HalI2CSendDma()
+#define HAL_I2C_DMA FALSE
+#endif
+
+#if HAL_I2C_DMA
+#include "hal_dma.h"
+#include "hal_drivers.h" // Hal_TaskID
+#endif
 
 // *************************   MACROS   ************************************
 
@@ -53,14 +64,65 @@
 #define OCM_SDA_LOW()  st( IO_DIR_PORT_PIN(OCM_SDA_PORT, OCM_SDA_PIN, IO_OUT); IO_PIN(OCM_SDA_PORT, OCM_SDA_PIN) = 0; )
 #define OCM_HPERIOD()  MicroWait(2)
 #define OCM_STRETCH()  MicroWait(10)
+#define OCM_STRETCHED() st( IO_TRACE(OCM_SCL_PORT, BV(OCM_SCL_PIN)); OCM_HPERIOD(); ) // SCL released by slave
 #define OCM_SSWAIT()   MicroWait(1000)
 
+#if HAL_I2C_DMA
+#if OCM_SCL_PORT != OCM_SDA_PORT
+#error "HAL_I2C_DMA requires SCL and SDA on the same port"
+#endif
+
+#if !defined HAL_I2C_DMA_CH            // DMA channel 1..4, not used by other drivers
+#define HAL_I2C_DMA_CH 2
+#endif
+
+#if !defined HAL_I2C_DMA_PHASE         // Timer 1 ticks (32MHz) per 1/4 of SCL period
+#define HAL_I2C_DMA_PHASE 80           // 100kHz, 5us SCL high and low
+#endif
+
+#define OCM_XDIR1(port) X_P##port##DIR
+#define OCM_XDIR(port)  OCM_XDIR1(port)
+#define OCM_DMA_WAVE    (8 * 4 + 3)    // PxDIR writes per byte: 4 per bit, ACK clock
+#endif
+
+// Bus busy time accounting, repeated START continues the section
+#if HAL_ACTIVE_STATS
+#define OCM_ACTIVE_BEGIN() st( if (!halI2CActive) { halI2CActive = 1; halI2CActiveStart = halActiveNow(); } )
+#define OCM_ACTIVE_END()   st( halI2CActive = 0; halActiveAdd(HAL_ACTIVE_I2C, halI2CActiveStart); )
+#else
+#define OCM_ACTIVE_BEGIN()
+#define OCM_ACTIVE_END()
+#endif
+
 // ************************* DECLARATIONS **********************************
 
 static inline  int8_t HalI2CStart(void);
 static inline  int8_t HalI2CStop(void);
 static inline uint8_t HalI2CReceiveByte(int8_t ack);
 static inline  int8_t HalI2CSendByte(uint8_t value);
+static inline  int8_t HalI2CReceiveData(uint8_t address, uint8_t *buffer, uint16_t len);
+#if HAL_I2C_DMA
+static void HalI2CDmaWave(uint8_t *wave, uint8_t base, uint8_t value);
+static void HalI2CDmaPrepare(void);
+static void HalI2CDmaNext(void);
+#endif
+
+#if HAL_I2C_DMA
+static uint8_t halI2CDmaWave[2][OCM_DMA_WAVE]; // played / being built
+static uint8_t *halI2CDmaBuf;                  // data of transfer in progress
+static uint16_t halI2CDmaLen;
+static volatile uint16_t halI2CDmaIdx;         // byte played, 0 for address
+static volatile uint8_t halI2CDmaReady;        // wave of byte after halI2CDmaIdx built
+static volatile uint8_t halI2CDmaHold;         // byte boundary left to task context
+static volatile int8_t halI2CDmaRet;           // I2C_E_BUSY until last ACK or NAK
+static uint8_t halI2CDmaBase;                  // PxDIR of other port pins
+static halI2CDmaCBack_t halI2CDmaCBack;        // NULL when idle
+#endif
+
+#if HAL_ACTIVE_STATS
+static uint8_t halI2CActive;       // between START and STOP
+static uint16_t halI2CActiveStart; // sleep timer at first START
+#endif
 
 /* PRIVATE */
 
@@ -76,6 +138,7 @@ static inline int8_t HalI2CStart(void)
 {
     uint8_t retry = HAL_I2C_STARTSTOP_WAITS;
 
+    OCM_ACTIVE_BEGIN();
     OCM_SDA_HIGH();
     OCM_HPERIOD();
     OCM_SCL_HIGH();
@@ -84,6 +147,7 @@ static inline int8_t HalI2CStart(void)
     {
         if (!retry--)
         {
+            OCM_ACTIVE_END();
             return I2C_E_ARB; // START timeout
         }
         OCM_SSWAIT();
@@ -125,6 +189,7 @@ static inline int8_t HalI2CStop(void)
     OCM_SDA_HIGH();
     OCM_HPERIOD();
 
+    OCM_ACTIVE_END();
     return ret;
 }
 
@@ -148,7 +213,7 @@ static inline uint8_t HalI2CReceiveByte(int8_t ack)
         for(stretch = 0; !(OCM_SCL_STATE) && stretch < HAL_I2C_STRETCH_WAITS; stretch++)
             OCM_STRETCH();
         if (stretch)
-            OCM_HPERIOD();
+            OCM_STRETCHED();
         rval = (rval << 1) | (OCM_SDA_STATE) != 0;
         OCM_SCL_LOW();
     }
@@ -164,7 +229,7 @@ static inline uint8_t HalI2CReceiveByte(int8_t ack)
     for(stretch = 0; !(OCM_SCL_STATE) && stretch < HAL_I2C_STRETCH_WAITS; stretch++)
         OCM_STRETCH();
     if (stretch)
-        OCM_HPERIOD();
+        OCM_STRETCHED();
     OCM_SCL_LOW();    
 
     return rval;
@@ -194,7 +259,7 @@ static inline int8_t HalI2CSendByte(uint8_t value)
         for(stretch = 0; !(OCM_SCL_STATE) && stretch < HAL_I2C_STRETCH_WAITS; stretch++)
             OCM_STRETCH();
         if (stretch)
-            OCM_HPERIOD();
+            OCM_STRETCHED();
         OCM_SCL_LOW();
         value <<= 1;
     }
@@ -207,13 +272,121 @@ static inline int8_t HalI2CSendByte(uint8_t value)
     for(stretch = 0; !(OCM_SCL_STATE) && stretch < HAL_I2C_STRETCH_WAITS; stretch++)
         OCM_STRETCH();
     if (stretch)
-        OCM_HPERIOD();
+        OCM_STRETCHED();
     ack = ((OCM_SDA_STATE) != 0);
     OCM_SCL_LOW();
 
     return ack;
 }
 
+#if HAL_I2C_DMA
+/*********************************************************************
+ * @fn      HalI2CDmaWave
+ * @brief   Expands byte into PxDIR values of one byte and ACK clock,
+ *          two phases of SCL low and two of SCL high per bit.
+ *          Expects SCL low on start, ends with SCL released for ACK
+ *          and one phase of ACK hold before DMA done interrupt.
+ * @param   wave - OCM_DMA_WAVE bytes target
+ * @param   base - PxDIR of other port pins
+ * @param   value - data byte to send
+ * @return  none
+ */
+static void HalI2CDmaWave(uint8_t *wave, uint8_t base, uint8_t value)
+{
+    uint8_t i, sda;
+
+    for (i = 0; i < 8; i++)
+    {
+        sda = (value & 0x80) ? 0 : BV(OCM_SDA_PIN);
+        *wave++ = base | BV(OCM_SCL_PIN) | sda; // data change on SCL low
+        *wave++ = base | sda;                   // SCL high
+        *wave++ = base | sda;                   // SCL high
+        *wave++ = base | BV(OCM_SCL_PIN) | sda; // SCL low, data hold
+        value <<= 1;
+    }
+
+    *wave++ = base | BV(OCM_SCL_PIN);           // release SDA
+    *wave++ = base;                             // SCL high
+    *wave = base;                               // ACK hold, checked by CPU
+}
+
+/*********************************************************************
+ * @fn      HalI2CDmaPrepare
+ * @brief   Expands the byte after the one being played, if any.
+ *          Task context.
+ * @param   none
+ * @return  none
+ */
+static void HalI2CDmaPrepare(void)
+{
+    uint16_t idx = halI2CDmaIdx;
+
+    if (halI2CDmaReady || idx >= halI2CDmaLen)
+        return;
+
+    HalI2CDmaWave(halI2CDmaWave[(idx + 1) & 1], halI2CDmaBase, halI2CDmaBuf[idx]);
+    halI2CDmaReady = TRUE;
+}
+
+/*********************************************************************
+ * @fn      HalI2CDmaNext
+ * @brief   Reads ACK bit at byte boundary, returns SCL low and plays
+ *          the next byte, or records the result after the last one.
+ *          Expects SCL high and the next byte expanded.
+ * @param   none
+ * @return  none
+ */
+static void HalI2CDmaNext(void)
+{
+    halDMADesc_t *ch;
+    int8_t ack;
+
+    ack = ((OCM_SDA_STATE) != 0);
+    OCM_SCL_LOW();
+    T1CNTL = 0; // SCL low for two phases before next bit
+
+    if (ack != I2C_ACK)
+    {
+        halI2CDmaRet = halI2CDmaIdx ? I2C_E_INCOMPLETE : I2C_E_NODEV;
+        return;
+    }
+    if (halI2CDmaIdx == halI2CDmaLen)
+    {
+        halI2CDmaRet = I2C_SUCCESS;
+        return;
+    }
+
+    halI2CDmaIdx++;
+    halI2CDmaReady = FALSE;
+    ch = HAL_DMA_GET_DESC1234(HAL_I2C_DMA_CH);
+    HAL_DMA_SET_SOURCE(ch, halI2CDmaWave[halI2CDmaIdx & 1]);
+    HAL_DMA_ARM_CH(HAL_I2C_DMA_CH);
+}
+
+/*********************************************************************
+ * @fn      HalI2CIsrDMA
+ * @brief   DMA done interrupt of HAL_I2C_DMA_CH, to be called from
+ *          halDmaIsr() in hal_dma.c. Plays the next byte when SCL is
+ *          high and the byte is expanded, otherwise leaves the byte
+ *          boundary to HalI2CPollDma(). Does not wait.
+ * @param   none
+ * @return  none
+ */
+void HalI2CIsrDMA(void)
+{
+    HAL_DMA_CLEAR_IRQ(HAL_I2C_DMA_CH);
+    if (halI2CDmaCBack == NULL || halI2CDmaRet != I2C_E_BUSY)
+        return;
+
+    if (!(OCM_SCL_STATE) || (!halI2CDmaReady && halI2CDmaIdx < halI2CDmaLen))
+        halI2CDmaHold = TRUE; // clock stretched or byte not expanded yet
+    else
+        HalI2CDmaNext();
+
+    osal_set_event(Hal_TaskID, HAL_I2C_DMA_EVENT);
+}
+#endif /* HAL_I2C_DMA */
+
 /*********************************************************************
 **********************************************************************/
 
@@ -226,21 +399,19 @@ static inline int8_t HalI2CSendByte(uint8_t value)
  * @return  void
  */
 void HalI2CInit(void) {
-    // Set port pins as inputs
-    IO_DIR_PORT_PIN(OCM_SCL_PORT, OCM_SCL_PIN, IO_IN);
-    IO_DIR_PORT_PIN(OCM_SDA_PORT, OCM_SDA_PIN, IO_IN);
-
-    // Set for general I/O operation
-    IO_FUNC_PORT_PIN(OCM_SCL_PORT, OCM_SCL_PIN, IO_GIO);
-    IO_FUNC_PORT_PIN(OCM_SDA_PORT, OCM_SDA_PIN, IO_GIO);
-
-    // Set I/O mode for pull-up/pull-down
-    IO_IMODE_PORT_PIN(OCM_SCL_PORT, OCM_SCL_PIN, IO_PUD);
-    IO_IMODE_PORT_PIN(OCM_SDA_PORT, OCM_SDA_PIN, IO_PUD);
+    // General I/O, inputs (released bus), pull-up/pull-down mode
+#if OCM_SCL_PORT == OCM_SDA_PORT
+    IO_CFG_PORT_MASK(OCM_SCL_PORT, BV(OCM_SCL_PIN) | BV(OCM_SDA_PIN), IO_GIO, IO_IN, IO_PUD);
+#else
+    IO_CFG_PORT_MASK(OCM_SCL_PORT, BV(OCM_SCL_PIN), IO_GIO, IO_IN, IO_PUD);
+    IO_CFG_PORT_MASK(OCM_SDA_PORT, BV(OCM_SDA_PIN), IO_GIO, IO_IN, IO_PUD);
+#endif
 
     // Set pins to pull-up
     IO_PUD_PORT(OCM_SCL_PORT, IO_PUP);
+#if OCM_SCL_PORT != OCM_SDA_PORT
     IO_PUD_PORT(OCM_SDA_PORT, IO_PUP);
+#endif
 }
 
 /*********************************************************************
@@ -253,12 +424,25 @@ void HalI2CInit(void) {
  */
 int8_t HalI2CReceive( uint8_t address, uint8_t *buffer, uint16_t len )
 {
-    uint16_t i;
-    int8_t ret;
-
     if (buffer == NULL)
         return I2C_E_INVAL;
 
+    return HalI2CReceiveData(address, buffer, len);
+}
+
+/*********************************************************************
+ * @fn      HalI2CReceiveData
+ * @brief   HalI2CReceive() without argument checks
+ * @param   address - address of the slave device
+ * @param   buffer - target array for received data
+ * @param   len - number of bytes to read, 1 or more
+ * @return  I2C_SUCCESS when successful, otherwise I2C_E_*
+ */
+static inline int8_t HalI2CReceiveData(uint8_t address, uint8_t *buffer, uint16_t len)
+{
+    uint16_t i;
+    int8_t ret;
+
     ret = HalI2CStart();
     if (ret != I2C_SUCCESS)
         return ret;
@@ -337,11 +521,26 @@ int8_t HalI2CSend( uint8_t address, uint8_t *buffer, uint16_t len )
  */
 int8_t HalI2CReadRegisters( uint8_t address, uint8_t reg, uint8_t *buffer, uint16_t len )
 {
-    int8_t ret;
-
     if (buffer == NULL)
         return I2C_E_INVAL;
 
+    return halI2CReadRegs(address, reg, buffer, len);
+}
+
+/*********************************************************************
+ * @fn      halI2CReadRegs
+ * @brief   HalI2CReadRegisters() without argument checks, used by
+ *          device table routines
+ * @param   address - address of the slave device
+ * @param   reg - register address to start read from
+ * @param   buffer - target array for received data
+ * @param   len - number of bytes to read, 1 or more
+ * @return  I2C_SUCCESS when successful, otherwise I2C_E_*
+ */
+int8_t halI2CReadRegs( uint8_t address, uint8_t reg, uint8_t *buffer, uint16_t len )
+{
+    int8_t ret;
+
     ret = HalI2CStart();
     if (ret != I2C_SUCCESS)
         return ret;
@@ -366,7 +565,7 @@ int8_t HalI2CReadRegisters( uint8_t address, uint8_t reg, uint8_t *buffer, uint1
     }
 
     /* Restart with read */
-    return HalI2CReceive(address, buffer, len);
+    return HalI2CReceiveData(address, buffer, len);
 }
 
 /*********************************************************************
@@ -380,12 +579,27 @@ int8_t HalI2CReadRegisters( uint8_t address, uint8_t reg, uint8_t *buffer, uint1
  */
 int8_t HalI2CWriteRegisters( uint8_t address, uint8_t reg, uint8_t *buffer, uint16_t len )
 {
-    uint16_t i = 0;
-    int8_t ret;
-
     if (buffer == NULL)
         return I2C_E_INVAL;
 
+    return halI2CWriteRegs(address, reg, buffer, len);
+}
+
+/*********************************************************************
+ * @fn      halI2CWriteRegs
+ * @brief   HalI2CWriteRegisters() without argument checks, used by
+ *          device table routines
+ * @param   address - address of the slave device
+ * @param   reg - register address to start writing to
+ * @param   buffer - ptr to buffered data to send
+ * @param   len - number of bytes in the buffer
+ * @return  I2C_SUCCESS when successful, otherwise I2C_E_*
+ */
+int8_t halI2CWriteRegs( uint8_t address, uint8_t reg, const uint8_t *buffer, uint16_t len )
+{
+    uint16_t i = 0;
+    int8_t ret;
+
     ret = HalI2CStart();
     if (ret != I2C_SUCCESS)
         return ret;
@@ -403,7 +617,7 @@ int8_t HalI2CWriteRegisters( uint8_t address, uint8_t reg, uint8_t *buffer, uint
         }
 
         for (i = 0; i < len; i++) {
-            if (!HalI2CSendByte(buffer[i])) // NAK
+            if (HalI2CSendByte(buffer[i]) != I2C_ACK) // NAK
             {
                 ret = I2C_E_INCOMPLETE;
                 break;
@@ -416,3 +630,203 @@ int8_t HalI2CWriteRegisters( uint8_t address, uint8_t reg, uint8_t *buffer, uint
     
     return ret;
 }
+
+/*********************************************************************
+ * @fn      HalI2CReadRegistersMsg
+ * @brief   Reads I2C slave registers directly into OSAL message
+ *          payload and sends it to task. Message is freed on error.
+ * @param   taskId - destination task
+ * @param   event - message event
+ * @param   address - address of the slave device
+ * @param   reg - register address to start read from
+ * @param   len - number of bytes to read
+ * @return  I2C_SUCCESS when message is sent, otherwise I2C_E_*
+ */
+int8_t HalI2CReadRegistersMsg( uint8_t taskId, uint8_t event, uint8_t address, uint8_t reg, uint16_t len )
+{
+    halI2CMsg_t *msg;
+    int8_t ret;
+
+    // osal_msg_allocate() takes 16 bit length including the message
+    if (len == 0 || len > 0xFFFF - sizeof(halI2CMsg_t))
+        return I2C_E_INVAL;
+
+    msg = (halI2CMsg_t *)osal_msg_allocate(sizeof(halI2CMsg_t) + len);
+    if (msg == NULL)
+        return I2C_E_NOMEM;
+
+    msg->data = (uint8_t *)(msg + 1);
+    ret = halI2CReadRegs(address, reg, msg->data, len);
+    if (ret != I2C_SUCCESS)
+    {
+        osal_msg_deallocate((uint8_t *)msg);
+        return ret;
+    }
+
+    msg->hdr.event = event;
+    msg->hdr.status = I2C_SUCCESS;
+    msg->address = address;
+    msg->reg = reg;
+    msg->len = len;
+
+    // osal_msg_send() frees message when task is invalid
+    if (osal_msg_send(taskId, (uint8_t *)msg) != SUCCESS)
+        return I2C_E_INVAL;
+
+    return I2C_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      HalI2CSendDma
+ * @brief   Starts sending buffer contents to an I2C slave device, bits
+ *          are played onto PxDIR by DMA paced with Timer 1 channel 0.
+ *          ACK is checked and next byte started from DMA done
+ *          interrupt, HalI2CPollDma() expands bytes, sets STOP and
+ *          calls cback. Without HAL_I2C_DMA the transfer is done by
+ *          HalI2CSend() and cback called before return.
+ * @param   address - address of the slave device
+ * @param   buffer - ptr to data to send, kept until cback
+ * @param   len - number of bytes in the buffer
+ * @param   cback - completion callback, I2C_SUCCESS or I2C_E_*
+ * @return  I2C_SUCCESS when transfer is started, otherwise I2C_E_*
+ */
+int8_t HalI2CSendDma( uint8_t address, uint8_t *buffer, uint16_t len, halI2CDmaCBack_t cback )
+{
+#if HAL_I2C_DMA
+    halDMADesc_t *ch = HAL_DMA_GET_DESC1234(HAL_I2C_DMA_CH);
+    int8_t ret;
+
+    if (buffer == NULL || cback == NULL)
+        return I2C_E_INVAL;
+    if (halI2CDmaCBack != NULL)
+        return I2C_E_BUSY;
+
+    ret = HalI2CStart();
+    if (ret != I2C_SUCCESS)
+        return ret;
+
+    halI2CDmaBuf = buffer;
+    halI2CDmaLen = len;
+    halI2CDmaIdx = 0;
+    halI2CDmaReady = (len != 0);
+    halI2CDmaHold = FALSE;
+    halI2CDmaRet = I2C_E_BUSY;
+    halI2CDmaCBack = cback;
+    // other pins of the port change direction with HalI2CDmaDir() until STOP
+    halI2CDmaBase = IO_DIR(OCM_SCL_PORT) & ~(BV(OCM_SCL_PIN) | BV(OCM_SDA_PIN));
+
+    HAL_DMA_SET_DEST(ch, &OCM_XDIR(OCM_SCL_PORT));
+    HAL_DMA_SET_VLEN(ch, HAL_DMA_VLEN_USE_LEN);
+    HAL_DMA_SET_LEN(ch, OCM_DMA_WAVE);
+    HAL_DMA_SET_WORD_SIZE(ch, HAL_DMA_WORDSIZE_BYTE);
+    HAL_DMA_SET_TRIG_MODE(ch, HAL_DMA_TMODE_SINGLE);
+    HAL_DMA_SET_TRIG_SRC(ch, HAL_DMA_TRIG_T1_CH0);
+    HAL_DMA_SET_SRC_INC(ch, HAL_DMA_SRCINC_1);
+    HAL_DMA_SET_DST_INC(ch, HAL_DMA_DSTINC_0);
+    HAL_DMA_SET_IRQ(ch, HAL_DMA_IRQMASK_ENABLE);
+    HAL_DMA_SET_M8(ch, HAL_DMA_M8_USE_8_BITS);
+    HAL_DMA_SET_PRIORITY(ch, HAL_DMA_PRI_HIGH);
+
+    HalI2CDmaWave(halI2CDmaWave[0], halI2CDmaBase, address << 1 | I2C_OP_WRITE);
+    if (len)
+        HalI2CDmaWave(halI2CDmaWave[1], halI2CDmaBase, buffer[0]);
+    HAL_DMA_SET_SOURCE(ch, halI2CDmaWave[0]);
+    HAL_DMA_CLEAR_IRQ(HAL_I2C_DMA_CH);
+    HAL_DMA_ARM_CH(HAL_I2C_DMA_CH);
+    DMAIE = 1;
+
+    // Timer 1 modulo mode, channel 0 compare event every phase
+    T1CTL = 0;
+    T1CC0L = LO_UINT16(HAL_I2C_DMA_PHASE - 1);
+    T1CC0H = HI_UINT16(HAL_I2C_DMA_PHASE - 1);
+    T1CCTL0 = 0x04;
+    T1CNTL = 0;
+    T1CTL = 0x02;
+
+    return I2C_SUCCESS;
+#else
+    if (cback == NULL)
+        return I2C_E_INVAL;
+
+    cback(HalI2CSend(address, buffer, len));
+    return I2C_SUCCESS;
+#endif
+}
+
+/*********************************************************************
+ * @fn      HalI2CPollDma
+ * @brief   Task part of HalI2CSendDma() transfer, HAL_I2C_DMA_EVENT
+ *          handler. Expands the next byte, waits for clock stretching
+ *          at byte boundary left by the interrupt, sets STOP and calls
+ *          the callback when the transfer is over.
+ * @param   none
+ * @return  none
+ */
+void HalI2CPollDma( void )
+{
+#if HAL_I2C_DMA
+    halI2CDmaCBack_t cback = halI2CDmaCBack;
+    uint8_t stretch;
+    int8_t ret;
+
+    if (cback == NULL)
+        return;
+
+    HalI2CDmaPrepare();
+    if (halI2CDmaHold)
+    {
+        for(stretch = 0; !(OCM_SCL_STATE) && stretch < HAL_I2C_STRETCH_WAITS; stretch++)
+            OCM_STRETCH();
+        if (stretch)
+            OCM_STRETCHED();
+        halI2CDmaHold = FALSE;
+        HalI2CDmaNext();
+        HalI2CDmaPrepare();
+    }
+
+    ret = halI2CDmaRet;
+    if (ret == I2C_E_BUSY)
+        return;
+
+    T1CTL = 0;
+    if (HalI2CStop() != I2C_SUCCESS)
+        ret = I2C_E_ARB;
+
+    halI2CDmaCBack = NULL;
+    cback(ret);
+#endif
+}
+
+/*********************************************************************
+ * @fn      HalI2CDmaDir
+ * @brief   Sets direction of other pins of SCL and SDA port. DMA
+ *          writes whole PxDIR, so while HalI2CSendDma() transfer runs
+ *          direct PxDIR changes are overwritten; this one updates the
+ *          waveforms being played as well. Task context.
+ * @param   mask - pins to change, SCL and SDA are ignored
+ * @param   dir - direction of the pins, bit set for output
+ * @return  none
+ */
+void HalI2CDmaDir( uint8_t mask, uint8_t dir )
+{
+    halIntState_t intState;
+#if HAL_I2C_DMA
+    uint8_t *wave = halI2CDmaWave[0];
+    uint8_t i;
+#endif
+
+    mask &= ~(BV(OCM_SCL_PIN) | BV(OCM_SDA_PIN));
+    dir &= mask;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    IO_DIR(OCM_SCL_PORT) = (IO_DIR(OCM_SCL_PORT) & ~mask) | dir;
+#if HAL_I2C_DMA
+    if (halI2CDmaCBack != NULL)
+    {
+        halI2CDmaBase = (halI2CDmaBase & ~mask) | dir;
+        for (i = 0; i < sizeof(halI2CDmaWave); i++)
+            wave[i] = (wave[i] & ~mask) | dir;
+    }
+#endif
+    HAL_EXIT_CRITICAL_SECTION(intState);
+}
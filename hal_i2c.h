@@ -10,15 +10,37 @@
 #ifndef HAL_I2C_H
 #define HAL_I2C_H
 
+#include "OSAL.h"
+
 enum {
     I2C_SUCCESS = 0,
     I2C_E_ARB,        // Arbitration error
     I2C_E_NODEV,      // No ACK on sending address
     I2C_E_INCOMPLETE, // NAK while sending data
     I2C_E_REG,        // NAK on sending register address
-    I2C_E_INVAL       // Invalid argument
+    I2C_E_INVAL,      // Invalid argument
+    I2C_E_NOMEM,      // Message allocation failed
+    I2C_E_BUSY        // DMA transfer in progress
 };
 
+// Hal task event of HalI2CSendDma() transfer, handled by HalI2CPollDma()
+#if !defined HAL_I2C_DMA_EVENT
+#define HAL_I2C_DMA_EVENT 0x0040
+#endif
+
+// Completion callback of HalI2CSendDma(), called from HalI2CPollDma()
+typedef void (*halI2CDmaCBack_t)(int8_t status);
+
+// Message delivered by HalI2CReadRegistersMsg()
+typedef struct
+{
+    osal_event_hdr_t hdr; // event given by caller, status I2C_SUCCESS
+    uint8_t address;      // slave device address
+    uint8_t reg;          // first register
+    uint16_t len;         // number of bytes in data
+    uint8_t *data;        // register values, placed right after the message
+} halI2CMsg_t;
+
 /*********************************************************************
  * @fn      HalI2CInit
  * @brief   Initializes two-wire serial I/O bus
@@ -69,4 +91,102 @@ int8_t HalI2CReadRegisters( uint8_t address, uint8_t reg, uint8_t *buffer, uint1
  */
 int8_t HalI2CWriteRegisters( uint8_t address, uint8_t reg, uint8_t *buffer, uint16_t len );
 
+/*
+ * HalI2CReadRegisters() / HalI2CWriteRegisters() without argument checks,
+ * for device table routines. Buffer must be valid, len 1 or more.
+ */
+int8_t halI2CReadRegs( uint8_t address, uint8_t reg, uint8_t *buffer, uint16_t len );
+int8_t halI2CWriteRegs( uint8_t address, uint8_t reg, const uint8_t *buffer, uint16_t len );
+
+/*********************************************************************
+ * @fn      HalI2CSendDma
+ * @brief   Starts sending buffer contents to an I2C slave device, DMA
+ *          paced when HAL_I2C_DMA is set. No other bus operation is
+ *          allowed until cback.
+ * @param   address - address of the slave device
+ * @param   buffer - ptr to data to send, kept until cback
+ * @param   len - number of bytes in the buffer
+ * @param   cback - called with I2C_SUCCESS or I2C_E_* when done
+ * @return  I2C_SUCCESS when transfer is started.
+ */
+int8_t HalI2CSendDma( uint8_t address, uint8_t *buffer, uint16_t len, halI2CDmaCBack_t cback );
+
+/*********************************************************************
+ * @fn      HalI2CIsrDMA
+ * @brief   DMA done interrupt of HAL_I2C_DMA_CH, called from
+ *          halDmaIsr() when HAL_I2C_DMA is set.
+ * @param   none
+ * @return  none
+ */
+void HalI2CIsrDMA(void);
+
+/*********************************************************************
+ * @fn      HalI2CPollDma
+ * @brief   HAL_I2C_DMA_EVENT handler, called from Hal_ProcessEvent().
+ *          Continues HalI2CSendDma() transfer, sets STOP and calls
+ *          the callback when done.
+ * @param   none
+ * @return  none
+ */
+void HalI2CPollDma( void );
+
+/*********************************************************************
+ * @fn      HalI2CDmaDir
+ * @brief   Sets direction of other pins of SCL and SDA port, kept by
+ *          HalI2CSendDma() transfer in progress.
+ * @param   mask - pins to change
+ * @param   dir - direction of the pins, bit set for output
+ * @return  none
+ */
+void HalI2CDmaDir( uint8_t mask, uint8_t dir );
+
+/*********************************************************************
+ * @fn      HalI2CReadRegistersMsg
+ * @brief   Reads I2C slave registers directly into OSAL message
+ *          payload and sends it to task. Message is freed on error.
+ * @param   taskId - destination task
+ * @param   event - message event
+ * @param   address - address of the slave device
+ * @param   reg - register address to start read from
+ * @param   len - number of bytes to read
+ * @return  I2C_SUCCESS when message is sent, otherwise I2C_E_*
+ */
+int8_t HalI2CReadRegistersMsg( uint8_t taskId, uint8_t event, uint8_t address, uint8_t reg, uint16_t len );
+
+/*********************************************************************
+ * Device descriptor table. HAL_I2C_DEVICE_TABLE names a header defining
+ *   HAL_I2C_DEVICES(DEV)   - DEV(dev, address) for each device
+ *   HAL_I2C_REGISTERS(REG) - REG(dev, name, reg, len, access) for each
+ *                            register block, len 1..255, access RO/WO/RW
+ * and generates inline access routines with constant address, register
+ * and length
+ *   int8_t HalI2CRead_<dev>_<name>( uint8_t *buffer );        RO, RW
+ *   int8_t HalI2CWrite_<dev>_<name>( const uint8_t *buffer ); WO, RW
+ * Buffer must hold len bytes, it is not checked.
+ */
+#if defined HAL_I2C_DEVICE_TABLE
+#include HAL_I2C_DEVICE_TABLE
+
+#define HAL_I2C_DEV_ADDR(dev, address) enum { HAL_I2C_ADDR_##dev = (address) };
+HAL_I2C_DEVICES(HAL_I2C_DEV_ADDR)
+
+#define HAL_I2C_LEN_CHECK(dev, name, len) \
+    typedef char halI2CLenCheck_##dev##_##name[((len) >= 1 && (len) <= 255) ? 1 : -1];
+#define HAL_I2C_FUNC_RO(dev, name, reg, len)                                  \
+    static inline int8_t HalI2CRead_##dev##_##name( uint8_t *buffer )         \
+    {                                                                         \
+        return halI2CReadRegs(HAL_I2C_ADDR_##dev, reg, buffer, len);          \
+    }
+#define HAL_I2C_FUNC_WO(dev, name, reg, len)                                  \
+    static inline int8_t HalI2CWrite_##dev##_##name( const uint8_t *buffer )  \
+    {                                                                         \
+        return halI2CWriteRegs(HAL_I2C_ADDR_##dev, reg, buffer, len);         \
+    }
+#define HAL_I2C_FUNC_RW(dev, name, reg, len) \
+    HAL_I2C_FUNC_RO(dev, name, reg, len) HAL_I2C_FUNC_WO(dev, name, reg, len)
+#define HAL_I2C_REG_FUNC(dev, name, reg, len, access) \
+    HAL_I2C_LEN_CHECK(dev, name, len) HAL_I2C_FUNC_##access(dev, name, reg, len)
+HAL_I2C_REGISTERS(HAL_I2C_REG_FUNC)
+#endif /* HAL_I2C_DEVICE_TABLE */
+
 #endif /* HAL_I2C_H */
@@ -0,0 +1,452 @@
+/**************************************************************************************************
+  Filename:       hal_i2c_slave.c
+
+  Revision:       20230128
+
+  Description:    Interrupt driven software I2C slave interface driver
+
+**************************************************************************************************/
+
+#include "hal_defs.h"
+#include "hal_mcu.h"
+#include "hal_gpio_defs.h"
+#include "hal_i2c_slave.h"
+#include "OnBoard.h"
+
+#ifndef HAL_I2C_SLAVE
+#define HAL_I2C_SLAVE FALSE
+#endif
+
+#if HAL_I2C_SLAVE
+
+#if defined POWER_SAVING
+#include "OSAL_PwrMgr.h"
+#endif
+
+// *************************   MACROS   ************************************
+
+// the default cofiguration below uses P1.2 for SCL and P1.3 for SDA.
+// port interrupt is owned by this driver, no key pins allowed on the port.
+#ifndef I2CS_PORT
+#define I2CS_PORT 1
+#endif
+#ifndef I2CS_SCL_PIN
+#define I2CS_SCL_PIN 2
+#endif
+#ifndef I2CS_SDA_PIN
+#define I2CS_SDA_PIN 3
+#endif
+
+#if !defined I2CS_SPIN_WAITS           // Maximum busy wait for SCL change in ISR
+#define I2CS_SPIN_WAITS 200            // loop iterations, approx. 50us
+#endif
+
+#define I2CS_SCL_BIT   BV(I2CS_SCL_PIN)
+#define I2CS_SDA_BIT   BV(I2CS_SDA_PIN)
+#define I2CS_EDGE_BITS (IO_EDGE_BIT(I2CS_PORT, I2CS_SCL_PIN) | IO_EDGE_BIT(I2CS_PORT, I2CS_SDA_PIN))
+
+// I2CS port I/O, open-drain via direction register
+#define I2CS_SCL_STATE  IO_PIN(I2CS_PORT, I2CS_SCL_PIN) // 0 for LOW, not 0 for HIGH
+#define I2CS_SDA_STATE  IO_PIN(I2CS_PORT, I2CS_SDA_PIN) // 0 for LOW, not 0 for HIGH
+#define I2CS_SCL_HIGH() IO_DIR_PORT_PIN(I2CS_PORT, I2CS_SCL_PIN, IO_IN)
+#define I2CS_SCL_LOW()  IO_DIR_PORT_PIN(I2CS_PORT, I2CS_SCL_PIN, IO_OUT) // stretch
+#define I2CS_SDA_HIGH() IO_DIR_PORT_PIN(I2CS_PORT, I2CS_SDA_PIN, IO_IN)
+#define I2CS_SDA_LOW()  IO_DIR_PORT_PIN(I2CS_PORT, I2CS_SDA_PIN, IO_OUT)
+#define I2CS_SDA_SET(v) st( if (v) I2CS_SDA_HIGH(); else I2CS_SDA_LOW(); )
+
+// Port interrupt enable and vector
+#if I2CS_PORT == 0
+#define I2CS_PORT_IE()  (IEN1 |= BV(5))
+#define I2CS_VECTOR     P0INT_VECTOR
+#elif I2CS_PORT == 1
+#define I2CS_PORT_IE()  (IEN2 |= BV(4))
+#define I2CS_VECTOR     P1INT_VECTOR
+#else
+#define I2CS_PORT_IE()  (IEN2 |= BV(1))
+#define I2CS_VECTOR     P2INT_VECTOR
+#endif
+
+// Bus states
+#define I2CS_IDLE    0 // waiting for START, SDA falling edge interrupt
+#define I2CS_RX      1 // receiving byte, SCL rising edge interrupt
+#define I2CS_RX_ACK  2 // ACK driven, 9th clock
+#define I2CS_TX      3 // sending byte
+#define I2CS_TX_ACK  4 // master ACK, 9th clock
+
+// Received byte meaning
+#define I2CS_ADDR    0
+#define I2CS_REG     1
+#define I2CS_DATA    2 // master write data
+#define I2CS_READ    3 // master read data
+
+// ************************* DECLARATIONS **********************************
+
+static uint8_t i2csAddress;
+static uint8_t *i2csRegs;
+static uint8_t i2csSize;
+static halI2CSlaveCBack_t i2csCBack;
+static uint8_t i2csTaskId = NO_TASK_ID;
+
+static volatile uint8_t i2csState = I2CS_IDLE;
+static uint8_t i2csPhase;  // I2CS_ADDR / I2CS_REG / I2CS_DATA / I2CS_READ
+static uint8_t i2csByte;   // byte being shifted
+static uint8_t i2csBits;   // bits shifted
+static uint8_t i2csReg;    // register pointer
+
+static uint8_t HalI2CSlaveWaitScl(uint8_t level);
+static    void HalI2CSlaveListen(void);
+static    void HalI2CSlaveEnd(void);
+static    void HalI2CSlaveStart(void);
+static    void HalI2CSlaveLoad(void);
+static uint8_t HalI2CSlaveReceived(void);
+static    void HalI2CSlaveClock(void);
+
+/* PRIVATE */
+
+/*********************************************************************
+ * @fn      HalI2CSlaveWaitScl
+ * @brief   Busy waits for SCL level
+ * @param   level - 0 or 1
+ * @return  not 0 when level reached, 0 on timeout
+ */
+static uint8_t HalI2CSlaveWaitScl(uint8_t level)
+{
+    uint8_t wait = I2CS_SPIN_WAITS;
+
+    while ((I2CS_SCL_STATE != 0) != level)
+    {
+        if (!wait--)
+            return 0;
+    }
+    return 1;
+}
+
+/*********************************************************************
+ * @fn      HalI2CSlaveListen
+ * @brief   Releases bus and arms SDA falling edge interrupt for START
+ * @param   none
+ * @return  none
+ */
+static void HalI2CSlaveListen(void)
+{
+    i2csState = I2CS_IDLE;
+    I2CS_SDA_HIGH();
+    I2CS_SCL_HIGH();
+    IO_IEN(I2CS_PORT) = (IO_IEN(I2CS_PORT) & ~I2CS_SCL_BIT) | I2CS_SDA_BIT;
+    PICTL |= I2CS_EDGE_BITS;
+    IO_IFG(I2CS_PORT) = ~(I2CS_SCL_BIT | I2CS_SDA_BIT);
+}
+
+/*********************************************************************
+ * @fn      HalI2CSlaveEnd
+ * @brief   Ends transaction, notifies and releases power hold
+ * @param   none
+ * @return  none
+ */
+static void HalI2CSlaveEnd(void)
+{
+    HalI2CSlaveListen();
+
+    if (i2csCBack && i2csPhase != I2CS_ADDR) // addressed
+        i2csCBack(I2CS_EV_STOP, i2csReg);
+
+#if defined POWER_SAVING
+    if (i2csTaskId != NO_TASK_ID)
+        osal_pwrmgr_task_state(i2csTaskId, PWRMGR_CONSERVE);
+#endif
+}
+
+/*********************************************************************
+ * @fn      HalI2CSlaveStart
+ * @brief   START or repeated START detected, SCL is stretched while
+ *          switching to SCL rising edge interrupt
+ * @param   none
+ * @return  none
+ */
+static void HalI2CSlaveStart(void)
+{
+    if (!HalI2CSlaveWaitScl(0))
+    {
+        HalI2CSlaveEnd();
+        return;
+    }
+    I2CS_SCL_LOW();
+
+#if defined POWER_SAVING
+    if (i2csTaskId != NO_TASK_ID)
+        osal_pwrmgr_task_state(i2csTaskId, PWRMGR_HOLD);
+#endif
+
+    i2csState = I2CS_RX;
+    i2csPhase = I2CS_ADDR;
+    i2csBits = 0;
+    i2csByte = 0;
+
+    IO_IEN(I2CS_PORT) = (IO_IEN(I2CS_PORT) & ~I2CS_SDA_BIT) | I2CS_SCL_BIT;
+    PICTL &= ~I2CS_EDGE_BITS;
+    IO_IFG(I2CS_PORT) = ~(I2CS_SCL_BIT | I2CS_SDA_BIT);
+
+    I2CS_SDA_HIGH();
+    I2CS_SCL_HIGH();
+}
+
+/*********************************************************************
+ * @fn      HalI2CSlaveLoad
+ * @brief   Loads next register to send
+ * @param   none
+ * @return  none
+ */
+static void HalI2CSlaveLoad(void)
+{
+    if (i2csCBack)
+        i2csCBack(I2CS_EV_READ, i2csReg);
+    i2csByte = i2csRegs[i2csReg];
+    if (++i2csReg >= i2csSize)
+        i2csReg = 0;
+}
+
+/*********************************************************************
+ * @fn      HalI2CSlaveReceived
+ * @brief   Handles received byte, SCL is stretched
+ * @param   none
+ * @return  I2C ACK (0) or NAK (1)
+ */
+static uint8_t HalI2CSlaveReceived(void)
+{
+    switch (i2csPhase)
+    {
+    case I2CS_ADDR:
+        if ((i2csByte >> 1) != i2csAddress)
+            return 1;
+        if (i2csByte & 0x01) // master read
+        {
+            HalI2CSlaveLoad();
+            i2csPhase = I2CS_READ;
+            return 0;
+        }
+        i2csPhase = I2CS_REG;
+        return 0;
+
+    case I2CS_REG:
+        if (i2csByte >= i2csSize)
+            return 1;
+        i2csReg = i2csByte;
+        i2csPhase = I2CS_DATA;
+        return 0;
+
+    default:
+        i2csRegs[i2csReg] = i2csByte;
+        if (i2csCBack)
+            i2csCBack(I2CS_EV_WRITE, i2csReg);
+        if (++i2csReg >= i2csSize)
+            i2csReg = 0;
+        return 0;
+    }
+}
+
+/*********************************************************************
+ * @fn      HalI2CSlaveClock
+ * @brief   SCL rising edge state machine
+ * @param   none
+ * @return  none
+ */
+static void HalI2CSlaveClock(void)
+{
+    uint8_t bit, wait;
+
+    switch (i2csState)
+    {
+    case I2CS_RX:
+        bit = I2CS_SDA_STATE != 0;
+        if (!I2CS_SCL_STATE) // late, SDA may belong to next bit
+        {
+            HalI2CSlaveEnd();
+            return;
+        }
+        i2csByte = (i2csByte << 1) | bit;
+
+        // SDA change while SCL is high on first bit: STOP or repeated START
+        if (++i2csBits == 1 && i2csPhase != I2CS_ADDR)
+        {
+            for (wait = I2CS_SPIN_WAITS; I2CS_SCL_STATE && wait; wait--)
+            {
+                if ((I2CS_SDA_STATE != 0) != bit)
+                {
+                    if (bit)
+                        HalI2CSlaveStart();
+                    else
+                        HalI2CSlaveEnd();
+                    return;
+                }
+            }
+            if (I2CS_SCL_STATE) // STOP missed, bus idle
+            {
+                HalI2CSlaveEnd();
+                return;
+            }
+        }
+        if (i2csBits < 8)
+            return;
+
+        if (!HalI2CSlaveWaitScl(0))
+        {
+            HalI2CSlaveEnd();
+            return;
+        }
+        I2CS_SCL_LOW();
+        if (HalI2CSlaveReceived())
+        {
+            HalI2CSlaveEnd(); // NAK, wait for next START
+            return;
+        }
+        I2CS_SDA_LOW();
+        i2csState = I2CS_RX_ACK;
+        I2CS_SCL_HIGH();
+        break;
+
+    case I2CS_RX_ACK:
+        if (!HalI2CSlaveWaitScl(0))
+        {
+            HalI2CSlaveEnd();
+            return;
+        }
+        i2csBits = 0;
+        if (i2csPhase == I2CS_READ)
+        {
+            // address for read acknowledged, first data bit
+            I2CS_SDA_SET(i2csByte & 0x80);
+            i2csBits = 1;
+            i2csState = I2CS_TX;
+        }
+        else
+        {
+            I2CS_SDA_HIGH();
+            i2csByte = 0;
+            i2csState = I2CS_RX;
+        }
+        break;
+
+    case I2CS_TX:
+        if (!HalI2CSlaveWaitScl(0))
+        {
+            HalI2CSlaveEnd();
+            return;
+        }
+        if (i2csBits < 8)
+        {
+            I2CS_SDA_SET(i2csByte & (0x80 >> i2csBits));
+            i2csBits++;
+        }
+        else
+        {
+            I2CS_SDA_HIGH(); // master ACK
+            i2csState = I2CS_TX_ACK;
+        }
+        break;
+
+    case I2CS_TX_ACK:
+        bit = I2CS_SDA_STATE != 0;
+        if (bit || !I2CS_SCL_STATE || !HalI2CSlaveWaitScl(0))
+        {
+            HalI2CSlaveEnd(); // NAK, master sends STOP, or ACK missed
+            return;
+        }
+        I2CS_SCL_LOW();
+        HalI2CSlaveLoad();
+        I2CS_SDA_SET(i2csByte & 0x80);
+        i2csBits = 1;
+        i2csState = I2CS_TX;
+        I2CS_SCL_HIGH();
+        break;
+    }
+}
+
+/*********************************************************************
+**********************************************************************/
+
+/* PUBLIC */
+
+/*********************************************************************
+ * @fn      HalI2CSlaveInit
+ * @brief   Starts listening for START condition as slave device
+ * @param   address - 7 bit slave address
+ * @param   regs - register map
+ * @param   size - number of registers
+ * @param   cback - event callback, may be NULL
+ * @param   taskId - task holding power while transaction is active,
+ *                   NO_TASK_ID if none
+ * @return  void
+ */
+void HalI2CSlaveInit(uint8_t address, uint8_t *regs, uint8_t size,
+                     halI2CSlaveCBack_t cback, uint8_t taskId)
+{
+    halIntState_t intState;
+
+    if (regs == NULL || size == 0)
+        return;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+
+    i2csAddress = address;
+    i2csRegs = regs;
+    i2csSize = size;
+    i2csCBack = cback;
+    i2csTaskId = taskId;
+    i2csReg = 0;
+
+    // open-drain: output latch low, direction switches level
+    IO_PIN(I2CS_PORT, I2CS_SCL_PIN) = 0;
+    IO_PIN(I2CS_PORT, I2CS_SDA_PIN) = 0;
+    IO_CFG_PORT_MASK(I2CS_PORT, I2CS_SCL_BIT | I2CS_SDA_BIT, IO_GIO, IO_IN, IO_PUD);
+
+    HalI2CSlaveListen();
+    IO_IF(I2CS_PORT) = 0;
+    I2CS_PORT_IE();
+
+    HAL_EXIT_CRITICAL_SECTION(intState);
+}
+
+/*********************************************************************
+ * @fn      HalI2CSlaveBusy
+ * @brief   Checks for active transaction
+ * @param   void
+ * @return  not 0 when transaction is active
+ */
+uint8_t HalI2CSlaveBusy(void)
+{
+    return i2csState != I2CS_IDLE;
+}
+
+/*********************************************************************
+ * @fn      halI2CSlavePortIsr
+ * @brief   Port ISR: START on SDA falling edge, clock on SCL rising edge
+ * @param   none
+ * @return  none
+ */
+HAL_ISR_FUNCTION(halI2CSlavePortIsr, I2CS_VECTOR)
+{
+    uint8_t flags;
+
+    HAL_ENTER_ISR();
+
+    // clear sampled flags only, edge after SCL release re-enters the ISR
+    flags = IO_IFG(I2CS_PORT);
+    IO_IFG(I2CS_PORT) = ~flags;
+    IO_IF(I2CS_PORT) = 0;
+    IO_TRACE(I2CS_PORT, flags);
+
+    if (i2csState == I2CS_IDLE)
+    {
+        if ((flags & I2CS_SDA_BIT) && I2CS_SCL_STATE && !I2CS_SDA_STATE)
+            HalI2CSlaveStart();
+    }
+    else if (flags & I2CS_SCL_BIT)
+    {
+        HalI2CSlaveClock();
+    }
+
+    CLEAR_SLEEP_MODE();
+    HAL_EXIT_ISR();
+}
+
+#endif /* HAL_I2C_SLAVE */
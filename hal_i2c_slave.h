@@ -0,0 +1,44 @@
+/**************************************************************************************************
+  Filename:       hal_i2c_slave.h
+
+  Revision:       20230128
+
+  Description:    Interrupt driven software I2C slave interface driver
+
+**************************************************************************************************/
+
+#ifndef HAL_I2C_SLAVE_H
+#define HAL_I2C_SLAVE_H
+
+// Callback events, called from port ISR while SCL is held low
+#define I2CS_EV_READ   0x01 // register is about to be sent, may be updated
+#define I2CS_EV_WRITE  0x02 // register was written
+#define I2CS_EV_STOP   0x03 // transaction ended, reg is next register pointer
+
+typedef void (*halI2CSlaveCBack_t)( uint8_t event, uint8_t reg );
+
+/*********************************************************************
+ * @fn      HalI2CSlaveInit
+ * @brief   Starts listening for START condition as slave device.
+ *          Master writes register pointer then data, or reads data
+ *          from register pointer, pointer auto increments and wraps.
+ * @param   address - 7 bit slave address
+ * @param   regs - register map
+ * @param   size - number of registers
+ * @param   cback - event callback, may be NULL
+ * @param   taskId - task holding power while transaction is active,
+ *                   NO_TASK_ID if none
+ * @return  void
+ */
+void    HalI2CSlaveInit( uint8_t address, uint8_t *regs, uint8_t size,
+                         halI2CSlaveCBack_t cback, uint8_t taskId );
+
+/*********************************************************************
+ * @fn      HalI2CSlaveBusy
+ * @brief   Checks for active transaction
+ * @param   void
+ * @return  not 0 when transaction is active
+ */
+uint8_t HalI2CSlaveBusy( void );
+
+#endif /* HAL_I2C_SLAVE_H */
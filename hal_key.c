@@ -15,6 +15,8 @@
 #include "OnBoard.h"
 #include "hal_defs.h"
 #include "hal_drivers.h"
+#include "hal_gpio_defs.h"
+#include "hal_active.h"
 #include "hal_mcu.h"
 #include "hal_types.h"
 #include "osal.h"
@@ -51,6 +53,211 @@
 #ifndef HAL_KEY_P2_INPUT_PINS_EDGE
   #define HAL_KEY_P2_INPUT_PINS_EDGE HAL_KEY_FALLING_EDGE
 #endif
+
+/* Input pins of port (0..2), preprocessor usable */
+#define HAL_KEY_INPUT_PINS(port) ((port) == 0 ? HAL_KEY_P0_INPUT_PINS : \
+                                  (port) == 1 ? HAL_KEY_P1_INPUT_PINS : HAL_KEY_P2_INPUT_PINS)
+
+/* Rotary encoders, pin A is interrupt source, pin B is sampled on pin A edges */
+#if defined HAL_KEY_ENC1_PORT
+  #if !defined HAL_KEY_ENC1_PIN_A || !defined HAL_KEY_ENC1_PIN_B
+    #error "HAL_KEY_ENC1_PIN_A and HAL_KEY_ENC1_PIN_B must be defined"
+  #endif
+  #if HAL_KEY_INPUT_PINS(HAL_KEY_ENC1_PORT)
+    #error "Encoder 1 port can not be shared with HAL_KEY_Px_INPUT_PINS"
+  #endif
+  #define HAL_KEY_ENC1_A_PINS(port) (HAL_KEY_ENC1_PORT == (port) ? BV(HAL_KEY_ENC1_PIN_A) : 0)
+  #define HAL_KEY_ENC1_PINS(port) (HAL_KEY_ENC1_PORT == (port) ? (BV(HAL_KEY_ENC1_PIN_A) | BV(HAL_KEY_ENC1_PIN_B)) : 0)
+#else
+  #define HAL_KEY_ENC1_A_PINS(port) 0
+  #define HAL_KEY_ENC1_PINS(port) 0
+#endif
+
+#if defined HAL_KEY_ENC2_PORT
+  #if !defined HAL_KEY_ENC1_PORT
+    #error "HAL_KEY_ENC2_PORT requires HAL_KEY_ENC1_PORT"
+  #endif
+  #if !defined HAL_KEY_ENC2_PIN_A || !defined HAL_KEY_ENC2_PIN_B
+    #error "HAL_KEY_ENC2_PIN_A and HAL_KEY_ENC2_PIN_B must be defined"
+  #endif
+  #if HAL_KEY_INPUT_PINS(HAL_KEY_ENC2_PORT)
+    #error "Encoder 2 port can not be shared with HAL_KEY_Px_INPUT_PINS"
+  #endif
+  #define HAL_KEY_ENC2_A_PINS(port) (HAL_KEY_ENC2_PORT == (port) ? BV(HAL_KEY_ENC2_PIN_A) : 0)
+  #define HAL_KEY_ENC2_PINS(port) (HAL_KEY_ENC2_PORT == (port) ? (BV(HAL_KEY_ENC2_PIN_A) | BV(HAL_KEY_ENC2_PIN_B)) : 0)
+  #if IO_EDGE_BIT(HAL_KEY_ENC1_PORT, HAL_KEY_ENC1_PIN_A) == IO_EDGE_BIT(HAL_KEY_ENC2_PORT, HAL_KEY_ENC2_PIN_A)
+    #error "Encoder 1 and 2 pin A can not share PICTL edge bit"
+  #endif
+  #define HAL_KEY_ENC_COUNT 2
+#elif defined HAL_KEY_ENC1_PORT
+  #define HAL_KEY_ENC2_A_PINS(port) 0
+  #define HAL_KEY_ENC2_PINS(port) 0
+  #define HAL_KEY_ENC_COUNT 1
+#else
+  #define HAL_KEY_ENC2_A_PINS(port) 0
+  #define HAL_KEY_ENC2_PINS(port) 0
+  #define HAL_KEY_ENC_COUNT 0
+#endif
+
+#define HAL_KEY_P0_ENC_PINS (HAL_KEY_ENC1_A_PINS(0) | HAL_KEY_ENC2_A_PINS(0))
+#define HAL_KEY_P1_ENC_PINS (HAL_KEY_ENC1_A_PINS(1) | HAL_KEY_ENC2_A_PINS(1))
+#define HAL_KEY_P2_ENC_PINS (HAL_KEY_ENC1_A_PINS(2) | HAL_KEY_ENC2_A_PINS(2))
+
+#ifndef HAL_KEY_ENC_REPORT_RATE
+  #define HAL_KEY_ENC_REPORT_RATE 20 // ms, delta events coalescing period
+#endif
+
+/* Pulse counter pins, subset of HAL_KEY_Px_INPUT_PINS counted in ISR */
+#ifndef HAL_KEY_P0_COUNTER_PINS
+  #define HAL_KEY_P0_COUNTER_PINS 0x00
+#endif
+
+#ifndef HAL_KEY_P1_COUNTER_PINS
+  #define HAL_KEY_P1_COUNTER_PINS 0x00
+#endif
+
+#ifndef HAL_KEY_P2_COUNTER_PINS
+  #define HAL_KEY_P2_COUNTER_PINS 0x00
+#endif
+
+#if (HAL_KEY_P0_COUNTER_PINS & ~HAL_KEY_P0_INPUT_PINS) || \
+    (HAL_KEY_P1_COUNTER_PINS & ~HAL_KEY_P1_INPUT_PINS) || \
+    (HAL_KEY_P2_COUNTER_PINS & ~HAL_KEY_P2_INPUT_PINS)
+  #error "HAL_KEY_Px_COUNTER_PINS must be a subset of HAL_KEY_Px_INPUT_PINS"
+#endif
+
+/* Key edge is flipped on the whole port, so counters can't share it with keys */
+#if (HAL_KEY_P0_COUNTER_PINS && (HAL_KEY_P0_INPUT_PINS & ~HAL_KEY_P0_COUNTER_PINS)) || \
+    (HAL_KEY_P1_COUNTER_PINS && (HAL_KEY_P1_INPUT_PINS & ~HAL_KEY_P1_COUNTER_PINS)) || \
+    (HAL_KEY_P2_COUNTER_PINS && (HAL_KEY_P2_INPUT_PINS & ~HAL_KEY_P2_COUNTER_PINS))
+  #error "Counter port can not have other HAL_KEY_Px_INPUT_PINS"
+#endif
+
+#define HAL_KEY_P0_KEY_PINS (HAL_KEY_P0_INPUT_PINS & ~HAL_KEY_P0_COUNTER_PINS)
+#define HAL_KEY_P1_KEY_PINS (HAL_KEY_P1_INPUT_PINS & ~HAL_KEY_P1_COUNTER_PINS)
+#define HAL_KEY_P2_KEY_PINS (HAL_KEY_P2_INPUT_PINS & ~HAL_KEY_P2_COUNTER_PINS)
+
+#define HAL_KEY_BITCOUNT(m) ((((m) >> 0) & 1) + (((m) >> 1) & 1) + (((m) >> 2) & 1) + (((m) >> 3) & 1) + \
+                             (((m) >> 4) & 1) + (((m) >> 5) & 1) + (((m) >> 6) & 1) + (((m) >> 7) & 1))
+
+/* Counters are stored compacted, port by port */
+#define HAL_KEY_P0_CNT_BASE 0
+#define HAL_KEY_P1_CNT_BASE (HAL_KEY_P0_CNT_BASE + HAL_KEY_BITCOUNT(HAL_KEY_P0_COUNTER_PINS))
+#define HAL_KEY_P2_CNT_BASE (HAL_KEY_P1_CNT_BASE + HAL_KEY_BITCOUNT(HAL_KEY_P1_COUNTER_PINS))
+#define HAL_KEY_CNT_COUNT   (HAL_KEY_P2_CNT_BASE + HAL_KEY_BITCOUNT(HAL_KEY_P2_COUNTER_PINS))
+
+#ifndef HAL_KEY_COUNTER_MIN_INTERVAL
+  #define HAL_KEY_COUNTER_MIN_INTERVAL 33 // sleep timer ticks (~1ms), shorter pulses are glitches
+#endif
+
+#ifndef HAL_KEY_COUNTER_REPORT_INTERVAL
+  #define HAL_KEY_COUNTER_REPORT_INTERVAL 60000 // ms, 0 disables periodic reports
+#endif
+
+#ifndef HAL_KEY_COUNTER_REPORT_THRESHOLD
+  #define HAL_KEY_COUNTER_REPORT_THRESHOLD 0 // pulses since last report, 0 disables
+#endif
+
+/* Interrupt storm throttling of key pins, HAL_KEY_STORM_THRESHOLD enables */
+#ifndef HAL_KEY_STORM_THRESHOLD
+  #define HAL_KEY_STORM_THRESHOLD 0 // key interrupts per window, 0 disables
+#endif
+
+#ifndef HAL_KEY_STORM_WINDOW
+  #define HAL_KEY_STORM_WINDOW 3277 // sleep timer ticks (~100ms)
+#endif
+
+#ifndef HAL_KEY_STORM_POLL_PERIOD
+  #define HAL_KEY_STORM_POLL_PERIOD 50 // ms, sampling period of throttled port
+#endif
+
+#ifndef HAL_KEY_STORM_SETTLE
+  #define HAL_KEY_STORM_SETTLE 20 // stable samples to re-enable interrupts
+#endif
+
+/* Batched delivery, all ports changes in one HAL_KEY_BATCH_CHANGE message */
+#ifndef HAL_KEY_BATCH
+  #define HAL_KEY_BATCH FALSE
+#endif
+
+/* ISR counts and edge to delivery latency statistics */
+#ifndef HAL_KEY_LATENCY_STATS
+  #define HAL_KEY_LATENCY_STATS FALSE
+#endif
+
+/*
+ * Sleep transitions only switch to 16MHz when DC/DC mode is changed with
+ * HAL_KEY_DCDC_BYPASS() / HAL_KEY_DCDC_ON() and the clock is not at 16MHz already
+ */
+#ifndef HAL_KEY_SLEEP_FAST
+  #define HAL_KEY_SLEEP_FAST FALSE
+#endif
+
+#if HAL_KEY_SLEEP_FAST && (defined HAL_KEY_DCDC_BYPASS != defined HAL_KEY_DCDC_ON)
+  #error "HAL_KEY_DCDC_BYPASS and HAL_KEY_DCDC_ON must be defined together"
+#endif
+
+#ifndef HAL_KEY_SPIN_CYCLES
+  #define HAL_KEY_SPIN_CYCLES 12 // CPU cycles per CLKCONSTA wait loop iteration, see listing
+#endif
+
+/*
+ * Keypad matrix: rows are driven low, columns are HAL_KEY_Px_INPUT_PINS of
+ * HAL_KEY_MATRIX_COL_PORT. Any press interrupts, then rows are scanned until all keys
+ * are released.
+ */
+#if defined HAL_KEY_MATRIX_ROW_PORT
+  #define HAL_KEY_MATRIX TRUE
+  #if !defined HAL_KEY_MATRIX_ROW_PINS || !defined HAL_KEY_MATRIX_COL_PORT
+    #error "HAL_KEY_MATRIX_ROW_PINS and HAL_KEY_MATRIX_COL_PORT must be defined"
+  #endif
+  #define HAL_KEY_MATRIX_COL_PINS HAL_KEY_INPUT_PINS(HAL_KEY_MATRIX_COL_PORT)
+  #if !HAL_KEY_MATRIX_COL_PINS
+    #error "HAL_KEY_Px_INPUT_PINS of HAL_KEY_MATRIX_COL_PORT must list columns"
+  #endif
+  #if HAL_KEY_INPUT_PINS(HAL_KEY_MATRIX_ROW_PORT) & HAL_KEY_MATRIX_ROW_PINS
+    #error "Matrix rows can not be HAL_KEY_Px_INPUT_PINS"
+  #endif
+  #if HAL_KEY_BITCOUNT(HAL_KEY_MATRIX_ROW_PINS) * HAL_KEY_BITCOUNT(HAL_KEY_MATRIX_COL_PINS) > 32
+    #error "Matrix is limited to 32 keys"
+  #endif
+  #if (HAL_KEY_MATRIX_COL_PORT == 0 && HAL_KEY_P0_INPUT_PINS_EDGE != HAL_KEY_FALLING_EDGE) || \
+      (HAL_KEY_MATRIX_COL_PORT == 1 && HAL_KEY_P1_INPUT_PINS_EDGE != HAL_KEY_FALLING_EDGE) || \
+      (HAL_KEY_MATRIX_COL_PORT == 2 && HAL_KEY_P2_INPUT_PINS_EDGE != HAL_KEY_FALLING_EDGE)
+    #error "Matrix columns must use HAL_KEY_FALLING_EDGE"
+  #endif
+  #define HAL_KEY_IS_MATRIX(port) (HAL_KEY_MATRIX_COL_PORT == (port))
+#else
+  #define HAL_KEY_MATRIX FALSE
+  #define HAL_KEY_IS_MATRIX(port) 0
+#endif
+
+/* Port interrupt of software I2C slave (hal_i2c_slave.c) can't be shared */
+#if defined HAL_I2C_SLAVE && HAL_I2C_SLAVE
+  #ifdef I2CS_PORT
+    #define HAL_KEY_I2CS_PORT I2CS_PORT
+  #else
+    #define HAL_KEY_I2CS_PORT 1
+  #endif
+  #if HAL_KEY_INPUT_PINS(HAL_KEY_I2CS_PORT) || (HAL_KEY_I2CS_PORT == 0 && HAL_KEY_P0_ENC_PINS) || \
+      (HAL_KEY_I2CS_PORT == 1 && HAL_KEY_P1_ENC_PINS) || (HAL_KEY_I2CS_PORT == 2 && HAL_KEY_P2_ENC_PINS)
+    #error "Key pins can not be on I2C slave port I2CS_PORT"
+  #endif
+#endif
+
+#ifndef HAL_KEY_MATRIX_SCAN_PERIOD
+  #define HAL_KEY_MATRIX_SCAN_PERIOD 10 // ms, scan period while any key is pressed
+#endif
+
+#ifndef HAL_KEY_MATRIX_SETTLE
+  #define HAL_KEY_MATRIX_SETTLE 5 // us, column settle time after row switch
+#endif
+
+/* Port SFR of numeric port */
+#define HAL_KEY_SFR(port, reg)  HAL_KEY_SFR1(port, reg)
+#define HAL_KEY_SFR1(port, reg) P##port##reg
+#define HAL_KEY_PORT_SFR(port)  HAL_KEY_PORT_SFR1(port)
+#define HAL_KEY_PORT_SFR1(port) P##port
 /**************************************************************************************************
  *                                            CONSTANTS
  **************************************************************************************************/
@@ -61,9 +268,60 @@
 #define HAL_KEY_P1_EDGE_BITS (HAL_KEY_BIT1 | HAL_KEY_BIT2)
 #define HAL_KEY_P2_EDGE_BITS HAL_KEY_BIT3
 
+/* Ports with key pins, pending key port compare is dropped when there is only one */
+#define HAL_KEY_KEY_PORTS ((HAL_KEY_P0_KEY_PINS ? HAL_KEY_PORT0 : 0) | \
+                           (HAL_KEY_P1_KEY_PINS ? HAL_KEY_PORT1 : 0) | \
+                           (HAL_KEY_P2_KEY_PINS ? HAL_KEY_PORT2 : 0))
+#define HAL_KEY_PORT_PENDING(n) (HAL_KEY_P##n##_KEY_PINS && \
+                                 (HAL_KEY_KEY_PORTS == HAL_KEY_PORT##n || portNum == HAL_KEY_PORT##n))
+
+/* HalKeyPoll pending work */
+#define HAL_KEY_PENDING_KEY 0x01
+#define HAL_KEY_PENDING_ENC 0x02
+#define HAL_KEY_PENDING_CNT 0x04
+#define HAL_KEY_PENDING_STORM 0x08
+#define HAL_KEY_PENDING_MATRIX 0x10
+
 /**************************************************************************************************
  *                                            TYPEDEFS
  **************************************************************************************************/
+#if HAL_KEY_ENC_COUNT
+typedef struct
+{
+    uint8 port;  // HAL_KEY_PORTx
+    uint8 pinA;  // interrupt pin mask
+    uint8 pinB;  // sampled pin mask
+    uint8 edge;  // PICTL edge bit of pin A
+} halKeyEncCfg_t;
+
+typedef struct
+{
+    uint8 lastA;    // pin A level at previous edge
+    int16 position; // accumulated steps
+    int16 delta;    // steps not reported yet
+} halKeyEnc_t;
+#endif
+
+#if HAL_KEY_CNT_COUNT
+typedef struct
+{
+    uint32 total;      // pulses counted
+    uint32 reported;   // total at last report
+    uint32 reportTime; // system clock at last report, ms
+    uint32 last;       // sleep timer at last pulse, 24 bit
+} halKeyCnt_t;
+#endif
+
+#if HAL_KEY_STORM_THRESHOLD
+typedef struct
+{
+    uint16 windowStart; // sleep timer at rate window start
+    uint16 count;       // key interrupts in window
+    uint8 throttled;    // port is sampled, key interrupts masked
+    uint8 levels;       // last sampled key pins state
+    uint8 stable;       // samples without change
+} halKeyStorm_t;
+#endif
 
 /**************************************************************************************************
  *                                        GLOBAL VARIABLES
@@ -75,11 +333,139 @@ bool Hal_KeyIntEnable;
  **************************************************************************************************/
 static uint8 portNum = 0;
 static uint8 pinNum = 0;
+static uint8 halKeyPending = 0;
+
+#if HAL_KEY_ENC_COUNT || HAL_KEY_CNT_COUNT || HAL_KEY_BATCH || HAL_KEY_MATRIX
+extern uint8 registeredKeysTaskID;
+#endif
+
+#if HAL_KEY_STORM_THRESHOLD || HAL_KEY_BATCH
+static const uint8 halKeyPins[3] = { HAL_KEY_P0_KEY_PINS, HAL_KEY_P1_KEY_PINS, HAL_KEY_P2_KEY_PINS };
+static const uint8 halKeyFallingEdge[3] =
+{
+    HAL_KEY_P0_INPUT_PINS_EDGE == HAL_KEY_FALLING_EDGE,
+    HAL_KEY_P1_INPUT_PINS_EDGE == HAL_KEY_FALLING_EDGE,
+    HAL_KEY_P2_INPUT_PINS_EDGE == HAL_KEY_FALLING_EDGE
+};
+static const uint8 halKeyEdgeBits[3] = { HAL_KEY_P0_EDGE_BITS, HAL_KEY_P1_EDGE_BITS, HAL_KEY_P2_EDGE_BITS };
+#endif
+
+#if HAL_KEY_ENC_COUNT
+
+static const halKeyEncCfg_t halKeyEncCfg[HAL_KEY_ENC_COUNT] =
+{
+    { BV(HAL_KEY_ENC1_PORT), BV(HAL_KEY_ENC1_PIN_A), BV(HAL_KEY_ENC1_PIN_B),
+      IO_EDGE_BIT(HAL_KEY_ENC1_PORT, HAL_KEY_ENC1_PIN_A) },
+#if HAL_KEY_ENC_COUNT > 1
+    { BV(HAL_KEY_ENC2_PORT), BV(HAL_KEY_ENC2_PIN_A), BV(HAL_KEY_ENC2_PIN_B),
+      IO_EDGE_BIT(HAL_KEY_ENC2_PORT, HAL_KEY_ENC2_PIN_A) },
+#endif
+};
+
+/*
+ * Quadrature step, indexed by (previous A << 2) | (A << 1) | B.
+ * CC2530 selects the edge per port, not per pin, so decoding runs on both edges
+ * of pin A with pin B sampled (x2 resolution). No A change means a missed or
+ * bounced edge and yields no step.
+ */
+static const int8 halKeyEncTable[8] =
+{
+    0, 0, 1, -1, // A was low: rising edge
+   -1, 1, 0, 0   // A was high: falling edge
+};
+
+static halKeyEnc_t halKeyEnc[HAL_KEY_ENC_COUNT];
+#endif
+
+#if HAL_KEY_CNT_COUNT
+static halKeyCnt_t halKeyCnt[HAL_KEY_CNT_COUNT];
+static uint32 halKeyCntReportTime;
+#endif
+
+#if HAL_KEY_STORM_THRESHOLD
+static halKeyStorm_t halKeyStorm[3];
+static halKeyStormStats_t halKeyStormStats[3];
+#endif
+
+#if HAL_KEY_BATCH
+static uint8 halKeyBatchChanged[3]; // pins flagged since last delivery
+static uint32 halKeyBatchTime[3];   // sleep timer at first flagged edge
+#endif
+
+#if HAL_KEY_LATENCY_STATS
+typedef struct
+{
+    uint32 isrCount;  // port interrupts
+    uint32 events;    // key events delivered
+    uint32 min;       // latency, sleep timer ticks
+    uint32 max;
+    uint32 sum;       // saturates, see sumEvents
+    uint32 sumEvents; // key events accounted in sum
+} halKeyLatency_t;
+
+static halKeyLatency_t halKeyLatency[3];
+
+/* 1 tick = 1000000 / 32768 us = 15625 / 512 us, split to keep within 32 bits */
+#define HAL_KEY_TICKS_TO_US(ticks) (((ticks) >> 9) * 15625 + (((ticks) & 511) * 15625 >> 9))
+
+#if !HAL_KEY_BATCH
+static uint32 halKeyEdgeTime; // sleep timer at first edge of pending key event
+#endif
+#endif
+
+#if HAL_KEY_SLEEP_FAST
+static halKeySleepStats_t halKeySleepStats; // wake latency in wait loop iterations until read
+#endif
+
+#if HAL_KEY_MATRIX
+static uint32 halKeyMatrixState; // debounced pressed keys
+static uint32 halKeyMatrixLast;  // previous scan
+#endif
 
 /**************************************************************************************************
  *                                        FUNCTIONS - Local
  **************************************************************************************************/
-static void halProcessKeyInterrupt(uint8 portNum);
+static void halProcessKeyInterrupt(uint8 portNum, uint8 pins);
+static void halKeyPollPending(void);
+#if HAL_KEY_ENC_COUNT || HAL_KEY_CNT_COUNT || HAL_KEY_STORM_THRESHOLD || HAL_KEY_MATRIX
+static void halKeyArmEvent(uint32 timeout);
+#endif
+#if HAL_KEY_BATCH || HAL_KEY_LATENCY_STATS || HAL_KEY_CNT_COUNT
+static uint32 halKeySleepTimer(void);
+#endif
+#if HAL_KEY_SLEEP_FAST && defined HAL_KEY_DCDC_ON
+static uint16 halKeyClockSwitch(uint8 clkcmd, uint8 clksta);
+#endif
+#if HAL_KEY_LATENCY_STATS
+static void halKeyLatencyUpdate(uint8 port, uint32 edgeTime);
+#endif
+#if HAL_KEY_STORM_THRESHOLD || HAL_KEY_BATCH
+static uint8 halKeyPressed(uint8 port, uint8 levels);
+static void halKeySetEdge(uint8 port, uint8 pressed);
+#endif
+#if HAL_KEY_BATCH
+static void halKeyBatchAdd(uint8 port, uint8 pins);
+static void halKeyBatchPoll(void);
+#endif
+#if HAL_KEY_ENC_COUNT
+static void halKeyEncoderConfig(void);
+static void halKeyEncoderIsr(uint8 port, uint8 levels);
+static void halKeyEncoderReport(void);
+#endif
+#if HAL_KEY_CNT_COUNT
+static void halKeyCounterIsr(uint8 pins, uint8 mask, halKeyCnt_t *cnt);
+static void halKeyCounterPoll(bool threshold);
+#endif
+#if HAL_KEY_STORM_THRESHOLD
+static bool halKeyStormIsr(uint8 port);
+static void halKeyStormPoll(void);
+#endif
+#if HAL_KEY_MATRIX
+static void halKeyMatrixIdle(void);
+static void halKeyMatrixIsr(void);
+static uint32 halKeyMatrixScan(void);
+static void halKeyMatrixPoll(void);
+#endif
 
 /**************************************************************************************************
  *                                        FUNCTIONS - API
@@ -97,20 +483,27 @@ static void halProcessKeyInterrupt(uint8 portNum);
 void HalKeyInit(void)
 {
 #if HAL_KEY_P0_INPUT_PINS
-    P0SEL &= ~HAL_KEY_P0_INPUT_PINS;
-    P0DIR &= ~(HAL_KEY_P0_INPUT_PINS);
+    IO_CFG_PORT_MASK(0, HAL_KEY_P0_INPUT_PINS, IO_GIO, IO_IN, IO_PUD);
 #endif
 
 #if HAL_KEY_P1_INPUT_PINS
-    P1SEL &= ~HAL_KEY_P1_INPUT_PINS;
-    P1DIR &= ~(HAL_KEY_P1_INPUT_PINS);
+    IO_CFG_PORT_MASK(1, HAL_KEY_P1_INPUT_PINS, IO_GIO, IO_IN, IO_PUD);
 #endif
 
 #if HAL_KEY_P2_INPUT_PINS
-    P2SEL &= ~HAL_KEY_P2_INPUT_PINS;
-    P2DIR &= ~(HAL_KEY_P2_INPUT_PINS);
+    IO_CFG_PORT_MASK(2, HAL_KEY_P2_INPUT_PINS, IO_GIO, IO_IN, IO_PUD);
+#endif
+
+#if HAL_KEY_CNT_COUNT
+    osal_memset(halKeyCnt, 0, sizeof(halKeyCnt));
 #endif
 
+#if HAL_KEY_MATRIX
+    HAL_KEY_PORT_SFR(HAL_KEY_MATRIX_ROW_PORT) &= ~HAL_KEY_MATRIX_ROW_PINS; // output latch low
+    IO_CFG_PORT_MASK(HAL_KEY_MATRIX_ROW_PORT, HAL_KEY_MATRIX_ROW_PINS, IO_GIO, IO_OUT, IO_PUD); // drive all rows
+    halKeyMatrixState = 0;
+    halKeyMatrixLast = 0;
+#endif
 }
 
 /**************************************************************************************************
@@ -130,7 +523,6 @@ void HalKeyConfig(bool interruptEnable, halKeyCBack_t cback)
 #if HAL_KEY_P0_INPUT_PINS
     P0IEN |= HAL_KEY_P0_INPUT_PINS;
     IEN1 |= HAL_KEY_BIT5;            // enable port0 int
-    P0INP &= ~HAL_KEY_P0_INPUT_PINS; // Pullup/pulldown
 
 #if (HAL_KEY_P0_INPUT_PINS_EDGE == HAL_KEY_FALLING_EDGE)
     P2INP &= ~HAL_KEY_BIT5; // pull up
@@ -147,7 +539,6 @@ void HalKeyConfig(bool interruptEnable, halKeyCBack_t cback)
 #if HAL_KEY_P1_INPUT_PINS
     P1IEN |= HAL_KEY_P1_INPUT_PINS;
     IEN2 |= HAL_KEY_BIT4; // enable port1 int
-    P1INP &= ~HAL_KEY_P1_INPUT_PINS; //Pullup/pulldown 
 #if (HAL_KEY_P1_INPUT_PINS_EDGE == HAL_KEY_FALLING_EDGE)
     P2INP &= ~HAL_KEY_BIT6;        // pull up
     MicroWait(50);
@@ -163,7 +554,6 @@ void HalKeyConfig(bool interruptEnable, halKeyCBack_t cback)
 #if HAL_KEY_P2_INPUT_PINS
     P2IEN |= HAL_KEY_P2_INPUT_PINS;
     IEN2 |= HAL_KEY_BIT1; // enable port2 int
-    P2INP &= ~HAL_KEY_P2_INPUT_PINS; //Pullup/pulldown
 #if (HAL_KEY_P2_INPUT_PINS_EDGE == HAL_KEY_FALLING_EDGE)
     P2INP &= ~HAL_KEY_BIT7;        // pull up
     MicroWait(50);
@@ -175,6 +565,14 @@ void HalKeyConfig(bool interruptEnable, halKeyCBack_t cback)
 #endif
 
 #endif
+
+#if HAL_KEY_ENC_COUNT
+    halKeyEncoderConfig();
+#endif
+
+#if HAL_KEY_CNT_COUNT
+    halKeyCounterPoll(false); // start periodic reports
+#endif
 }
 
 /**************************************************************************************************
@@ -204,6 +602,22 @@ void HalKeyEnterSleep(void)
 {
     uint8 clkcmd = CLKCONCMD;
     uint8 clksta = CLKCONSTA;
+    HAL_ACTIVE_BEGIN(activeStart);
+
+#if HAL_KEY_SLEEP_FAST
+    halKeySleepStats.sleeps++;
+#if defined HAL_KEY_DCDC_BYPASS
+    // Switch to 16MHz before setting the DC/DC to bypass to reduce risk of flash corruption
+    halKeyClockSwitch(CLKCONCMD_16MHZ | OSC_32KHZ, CLKCONCMD_16MHZ | OSC_32KHZ);
+    HAL_KEY_DCDC_BYPASS();
+    halKeyClockSwitch(clkcmd, clksta);
+#else
+    // no DC/DC transition, no clock switch required on entry nor exit, counted once
+    halKeySleepStats.skipped++;
+    (void)clkcmd;
+    (void)clksta;
+#endif
+#else
     // Switch to 16MHz before setting the DC/DC to bypass to reduce risk of flash corruption
     CLKCONCMD = (CLKCONCMD_16MHZ | OSC_32KHZ);
     // wait till clock speed stablizes
@@ -213,6 +627,9 @@ void HalKeyEnterSleep(void)
     CLKCONCMD = clkcmd;
     while (CLKCONSTA != (clksta))
         ;
+#endif
+
+    HAL_ACTIVE_END(HAL_ACTIVE_KEY_SLEEP, activeStart);
 }
 
 /**************************************************************************************************
@@ -227,6 +644,32 @@ void HalKeyEnterSleep(void)
 uint8 HalKeyExitSleep(void)
 {
     uint8 clkcmd = CLKCONCMD;
+    HAL_ACTIVE_BEGIN(activeStart);
+#if HAL_KEY_SLEEP_FAST
+#if defined HAL_KEY_DCDC_ON
+    uint16 spins;
+
+    // Switch to 16MHz before setting the DC/DC to on to reduce risk of flash corruption
+    spins = halKeyClockSwitch(CLKCONCMD_16MHZ | OSC_32KHZ, CLKCONCMD_16MHZ | OSC_32KHZ);
+    HAL_KEY_DCDC_ON();
+    if (CLKCONCMD != clkcmd)
+    {
+        CLKCONCMD = clkcmd; // not waiting for the clock, as stock driver
+        halKeySleepStats.switches++;
+    }
+    else
+    {
+        halKeySleepStats.skipped++;
+    }
+
+    // wake to ready latency is the clock switch wait, no timer runs at that point
+    halKeySleepStats.wakeLast = spins;
+    if (spins > halKeySleepStats.wakeMax)
+        halKeySleepStats.wakeMax = spins;
+#else
+    (void)clkcmd; // no wait on wake, skip counted on entry
+#endif
+#else
     // Switch to 16MHz before setting the DC/DC to on to reduce risk of flash corruption
     CLKCONCMD = (CLKCONCMD_16MHZ | OSC_32KHZ);
     // wait till clock speed stablizes
@@ -234,6 +677,9 @@ uint8 HalKeyExitSleep(void)
         ;
 
     CLKCONCMD = clkcmd;
+#endif
+
+    HAL_ACTIVE_END(HAL_ACTIVE_KEY_SLEEP, activeStart);
 
     // /* Wake up and read keys */
     return (HalKeyRead());
@@ -250,142 +696,1200 @@ uint8 HalKeyExitSleep(void)
  **************************************************************************************************/
 void HalKeyPoll(void)
 {
+    HAL_ACTIVE_BEGIN(activeStart);
+
+    halKeyPollPending();
+
+    HAL_ACTIVE_END(HAL_ACTIVE_KEY_POLL, activeStart);
+}
+
+/**************************************************************************************************
+ * @fn      halKeyPollPending
+ *
+ * @brief   Handle pending key, encoder, counter, storm and matrix work
+ *
+ * @param   None
+ *
+ * @return  None
+ **************************************************************************************************/
+static void halKeyPollPending(void)
+{
+#if !HAL_KEY_BATCH
     uint8 pinStatus = 0;
     bool isPressed = false;
-    switch (portNum)
+#endif
+    halIntState_t intState;
+    uint8 pending;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    pending = halKeyPending;
+    halKeyPending = 0;
+    HAL_EXIT_CRITICAL_SECTION(intState);
+
+#if HAL_KEY_ENC_COUNT
+    if (pending & HAL_KEY_PENDING_ENC)
+        halKeyEncoderReport();
+#endif
+
+#if HAL_KEY_CNT_COUNT
+    halKeyCounterPoll(pending & HAL_KEY_PENDING_CNT);
+#endif
+
+#if HAL_KEY_STORM_THRESHOLD
+    if (pending & HAL_KEY_PENDING_STORM)
+        halKeyStormPoll();
+#endif
+
+#if HAL_KEY_MATRIX
+    if (pending & HAL_KEY_PENDING_MATRIX)
+        halKeyMatrixPoll();
+#endif
+
+#if HAL_KEY_BATCH
+    if (pending & (HAL_KEY_PENDING_KEY | HAL_KEY_PENDING_STORM))
+        halKeyBatchPoll(); // also delivers storm sampled changes
+#else
+    if (!(pending & HAL_KEY_PENDING_KEY))
+        return;
+
+    // constant conditions, branches of ports without keys are not compiled
+    if (HAL_KEY_PORT_PENDING(0))
     {
-    case HAL_KEY_PORT0:
         PICTL ^= HAL_KEY_P0_EDGE_BITS; // flip edge bit
         pinStatus = P0 & pinNum;
         isPressed = HAL_KEY_P0_INPUT_PINS_EDGE != !!(pinStatus);
-        break;
-
-    case HAL_KEY_PORT1:
+    }
+    else if (HAL_KEY_PORT_PENDING(1))
+    {
         PICTL ^= HAL_KEY_P1_EDGE_BITS; // flip edge bit
         pinStatus = P1 & pinNum;
         isPressed = HAL_KEY_P1_INPUT_PINS_EDGE != !!(pinStatus);
-        break;
-
-    case HAL_KEY_PORT2:
+    }
+    else if (HAL_KEY_PORT_PENDING(2))
+    {
         PICTL ^= HAL_KEY_P2_EDGE_BITS; // flip edge bit
         pinStatus = P2 & pinNum;
         isPressed = HAL_KEY_P2_INPUT_PINS_EDGE != !!(pinStatus);
-        break;
-
-    default:
-        break;
     }
     DBGF("portNum=0x%X pinNum=0x%X isPressed=%d\r\n", portNum, pinNum, isPressed);
 
     // DBGF("pinStatus=" BYTE_TO_BINARY_PATTERN "\r\n", BYTE_TO_BINARY(pinStatus));
     OnBoard_SendKeys(pinNum, (isPressed ? HAL_KEY_PRESS : HAL_KEY_RELEASE) | portNum);
+#if HAL_KEY_LATENCY_STATS
+    halKeyLatencyUpdate(portNum >> 1, halKeyEdgeTime);
+#endif
+#endif /* HAL_KEY_BATCH */
 }
 
-static void halProcessKeyInterrupt(uint8 _portNum)
+static void halProcessKeyInterrupt(uint8 _portNum, uint8 pins)
 {
+#if HAL_KEY_LATENCY_STATS && !HAL_KEY_BATCH
+    if (!(halKeyPending & HAL_KEY_PENDING_KEY))
+        halKeyEdgeTime = halKeySleepTimer();
+#endif
     portNum = _portNum;
-    switch (_portNum)
-    {
-    case HAL_KEY_PORT0:
-        pinNum = P0IFG & HAL_KEY_P0_INPUT_PINS;
-        break;
+    pinNum = pins;
+    halKeyPending |= HAL_KEY_PENDING_KEY;
+#if HAL_KEY_BATCH
+    halKeyBatchAdd(_portNum >> 1, pins); // HAL_KEY_PORTx to port number
+#endif
+    osal_start_timerEx(Hal_TaskID, HAL_KEY_EVENT, HAL_KEY_DEBOUNCE_VALUE);
+}
 
-    case HAL_KEY_PORT1:
-        pinNum = P1IFG & HAL_KEY_P1_INPUT_PINS;
-        break;
+#if HAL_KEY_ENC_COUNT || HAL_KEY_CNT_COUNT || HAL_KEY_STORM_THRESHOLD || HAL_KEY_MATRIX
+/**************************************************************************************************
+ * @fn      halKeyArmEvent
+ *
+ * @brief   Schedule HalKeyPoll for non-key work. Pending key debounce keeps its timer,
+ *          otherwise a running timer is only shortened.
+ *
+ * @param   timeout - ms
+ *
+ * @return  None
+ **************************************************************************************************/
+static void halKeyArmEvent(uint32 timeout)
+{
+    uint32 left;
 
-    case HAL_KEY_PORT2:
-        pinNum = P2IFG & HAL_KEY_P2_INPUT_PINS;
-        break;
-    default:
-        break;
-    }
-    osal_start_timerEx(Hal_TaskID, HAL_KEY_EVENT, HAL_KEY_DEBOUNCE_VALUE);
+    if (halKeyPending & HAL_KEY_PENDING_KEY)
+        return;
+
+    left = osal_get_timeoutEx(Hal_TaskID, HAL_KEY_EVENT);
+    if (left == 0 || left > timeout)
+        osal_start_timerEx(Hal_TaskID, HAL_KEY_EVENT, timeout);
 }
+#endif
 
-/***************************************************************************************************
- *                                    INTERRUPT SERVICE ROUTINE
- ***************************************************************************************************/
+#if HAL_KEY_BATCH || HAL_KEY_LATENCY_STATS || HAL_KEY_CNT_COUNT
+/**************************************************************************************************
+ * @fn      halKeySleepTimer
+ *
+ * @brief   Read 24-bit sleep timer, 32768 Hz, runs in all power modes
+ *
+ * @param   None
+ *
+ * @return  sleep timer value
+ **************************************************************************************************/
+static uint32 halKeySleepTimer(void)
+{
+    uint32 t = ST0; // ST0 read latches ST1, ST2
+    t |= (uint32)ST1 << 8;
+    t |= (uint32)ST2 << 16;
+    return t;
+}
+#endif
 
+#if HAL_KEY_SLEEP_FAST
+#if defined HAL_KEY_DCDC_ON
 /**************************************************************************************************
- * @fn      halKeyPort0Isr
+ * @fn      halKeyClockSwitch
  *
- * @brief   Port0 ISR
+ * @brief   Switch system clock unless already there, accounting wait loop iterations
  *
- * @param
+ * @param   clkcmd - CLKCONCMD value to set
+ *          clksta - CLKCONSTA value to wait for
  *
- * @return
+ * @return  wait loop iterations
  **************************************************************************************************/
-#if HAL_KEY_P0_INPUT_PINS
-HAL_ISR_FUNCTION(halKeyPort0Isr, P0INT_VECTOR)
+static uint16 halKeyClockSwitch(uint8 clkcmd, uint8 clksta)
 {
-    HAL_ENTER_ISR();
+    uint16 spins = 0;
 
-    if (P0IFG & HAL_KEY_P0_INPUT_PINS)
+    if (CLKCONSTA == clksta)
     {
-        halProcessKeyInterrupt(HAL_KEY_PORT0);
+        halKeySleepStats.skipped++;
+        return 0;
     }
 
-    P0IFG = 0; //&= ~HAL_KEY_P0_INPUT_PINS;
-    P0IF = 0;
+    CLKCONCMD = clkcmd;
+    // wait till clock speed stablizes
+    while (CLKCONSTA != clksta)
+        spins++;
 
-    CLEAR_SLEEP_MODE();
-    HAL_EXIT_ISR();
+    halKeySleepStats.switches++;
+    halKeySleepStats.spinTotal += spins;
+    if (spins > halKeySleepStats.spinMax)
+        halKeySleepStats.spinMax = spins;
+    return spins;
+}
+#endif
+
+/**************************************************************************************************
+ * @fn      HalKeySleepStats
+ *
+ * @brief   Read sleep transitions statistics
+ *
+ * @param   stats - target structure
+ *
+ * @return  None
+ **************************************************************************************************/
+void HalKeySleepStats(halKeySleepStats_t *stats)
+{
+    if (stats == NULL)
+        return;
+
+    *stats = halKeySleepStats;
+    // wait loop runs at 16MHz or faster, giving an upper bound
+    stats->wakeLast = (uint16)((uint32)stats->wakeLast * HAL_KEY_SPIN_CYCLES / 16);
+    stats->wakeMax = (uint16)((uint32)stats->wakeMax * HAL_KEY_SPIN_CYCLES / 16);
 }
-#endif /* HAL_KEY_P0_INPUT_PINS */
+#else
+void HalKeySleepStats(halKeySleepStats_t *stats) {}
+#endif /* HAL_KEY_SLEEP_FAST */
 
+#if HAL_KEY_LATENCY_STATS
 /**************************************************************************************************
- * @fn      halKeyPort1Isr
+ * @fn      halKeyLatencyUpdate
  *
- * @brief   Port1 ISR
+ * @brief   Account edge to delivery latency of key event
  *
- * @param
+ * @param   port - port number (0..2)
+ *          edgeTime - sleep timer at first edge
  *
- * @return
+ * @return  None
  **************************************************************************************************/
-#if HAL_KEY_P1_INPUT_PINS
-HAL_ISR_FUNCTION(halKeyPort1Isr, P1INT_VECTOR)
+static void halKeyLatencyUpdate(uint8 port, uint32 edgeTime)
 {
-    HAL_ENTER_ISR();
+    halKeyLatency_t *lat = &halKeyLatency[port];
+    uint32 ticks = (halKeySleepTimer() - edgeTime) & 0x00FFFFFF; // 24-bit timer
 
-    if (P1IFG & HAL_KEY_P1_INPUT_PINS)
+    if (lat->events == 0 || ticks < lat->min)
+        lat->min = ticks;
+    if (ticks > lat->max)
+        lat->max = ticks;
+    if (lat->sum <= 0xFFFFFFFF - ticks)
     {
-        halProcessKeyInterrupt(HAL_KEY_PORT1);
+        lat->sum += ticks;
+        lat->sumEvents++;
     }
-
-    P1IFG = 0; //&= ~HAL_KEY_P1_INPUT_PINS;
-    P1IF = 0;
-
-    CLEAR_SLEEP_MODE();
-    HAL_EXIT_ISR();
+    lat->events++;
 }
-#endif /* HAL_KEY_P1_INPUT_PINS */
 
 /**************************************************************************************************
- * @fn      halKeyPort2Isr
+ * @fn      HalKeyLatencyStats
  *
- * @brief   Port2 ISR
+ * @brief   Read ISR counts and edge to delivery latency statistics of the port
  *
- * @param
+ * @param   port - HAL_KEY_PORTx
+ *          stats - target structure
+ *          reset - clear statistics after reading
  *
- * @return
+ * @return  None
  **************************************************************************************************/
-#if HAL_KEY_P2_INPUT_PINS
-HAL_ISR_FUNCTION(halKeyPort2Isr, P2INT_VECTOR)
+void HalKeyLatencyStats(uint8 port, halKeyLatencyStats_t *stats, bool reset)
 {
-    HAL_ENTER_ISR();
+    halKeyLatency_t lat;
+    halIntState_t intState;
+    uint8 i = (port == HAL_KEY_PORT0) ? 0 : (port == HAL_KEY_PORT1) ? 1 : 2;
 
-    if (P2IFG & HAL_KEY_P2_INPUT_PINS) {
-        halProcessKeyInterrupt(HAL_KEY_PORT2);
-    }
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    lat = halKeyLatency[i];
+    if (reset)
+        osal_memset(&halKeyLatency[i], 0, sizeof(halKeyLatency_t));
+    HAL_EXIT_CRITICAL_SECTION(intState);
+
+    if (stats == NULL)
+        return;
+
+    stats->isrCount = lat.isrCount;
+    stats->events = lat.events;
+    stats->latencyMin = HAL_KEY_TICKS_TO_US(lat.min);
+    stats->latencyMax = HAL_KEY_TICKS_TO_US(lat.max);
+    stats->latencyAvg = lat.sumEvents ? HAL_KEY_TICKS_TO_US(lat.sum / lat.sumEvents) : 0;
+}
+#else
+void HalKeyLatencyStats(uint8 port, halKeyLatencyStats_t *stats, bool reset) {}
+#endif /* HAL_KEY_LATENCY_STATS */
+
+#if HAL_KEY_STORM_THRESHOLD || HAL_KEY_BATCH
+/**************************************************************************************************
+ * @fn      halKeyPressed
+ *
+ * @brief   Translate key pins levels to pressed keys according to port edge setting
+ *
+ * @param   port - port number (0..2)
+ *          levels - port pins state
+ *
+ * @return  pressed key pins
+ **************************************************************************************************/
+static uint8 halKeyPressed(uint8 port, uint8 levels)
+{
+    return (halKeyFallingEdge[port] ? ~levels : levels) & halKeyPins[port];
+}
+
+/**************************************************************************************************
+ * @fn      halKeySetEdge
+ *
+ * @brief   Select port edge from keys state: next interrupt on press when all keys
+ *          are released, on release otherwise
+ *
+ * @param   port - port number (0..2)
+ *          pressed - pressed key pins
+ *
+ * @return  None
+ **************************************************************************************************/
+static void halKeySetEdge(uint8 port, uint8 pressed)
+{
+    if (halKeyFallingEdge[port] ^ (pressed != 0))
+        PICTL |= halKeyEdgeBits[port];
+    else
+        PICTL &= ~halKeyEdgeBits[port];
+}
+#endif
+
+#if HAL_KEY_BATCH
+/**************************************************************************************************
+ * @fn      halKeyBatchAdd
+ *
+ * @brief   Accumulate changed key pins for batched delivery
+ *
+ * @param   port - port number (0..2)
+ *          pins - changed pins
+ *
+ * @return  None
+ **************************************************************************************************/
+static void halKeyBatchAdd(uint8 port, uint8 pins)
+{
+    if (!halKeyBatchChanged[port])
+        halKeyBatchTime[port] = halKeySleepTimer();
+    halKeyBatchChanged[port] |= pins;
+}
+
+/**************************************************************************************************
+ * @fn      halKeyBatchPoll
+ *
+ * @brief   Deliver changes of all ports in single HAL_KEY_BATCH_CHANGE message
+ *
+ * @param   None
+ *
+ * @return  None
+ **************************************************************************************************/
+static void halKeyBatchPoll(void)
+{
+    halKeyBatchChange_t *msg;
+    halIntState_t intState;
+    uint8 changed[3];
+    uint32 edgeTime[3];
+    uint8 port;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    for (port = 0; port < 3; port++)
+    {
+        changed[port] = halKeyBatchChanged[port];
+        edgeTime[port] = halKeyBatchTime[port];
+        halKeyBatchChanged[port] = 0;
+    }
+    HAL_EXIT_CRITICAL_SECTION(intState);
+
+    if (!(changed[0] | changed[1] | changed[2]))
+        return;
+
+    msg = (registeredKeysTaskID == NO_TASK_ID) ? NULL :
+          (halKeyBatchChange_t *)osal_msg_allocate(sizeof(halKeyBatchChange_t));
+
+    for (port = 0; port < 3; port++)
+    {
+        uint8 pressed = halKeyPressed(port, (port == 0) ? P0 : (port == 1) ? P1 : P2);
+
+        if (changed[port])
+        {
+#if HAL_KEY_STORM_THRESHOLD
+            if (!halKeyStorm[port].throttled)
+#endif
+            {
+                halKeySetEdge(port, pressed);
+#if HAL_KEY_LATENCY_STATS
+                halKeyLatencyUpdate(port, edgeTime[port]);
+#endif
+            }
+        }
+
+        if (msg)
+        {
+            msg->changed[port] = changed[port];
+            msg->state[port] = pressed;
+            msg->edgeTime[port] = changed[port] ? edgeTime[port] : 0;
+        }
+    }
+
+    if (msg)
+    {
+        msg->hdr.event = HAL_KEY_BATCH_CHANGE;
+        msg->hdr.status = 0;
+        msg->pollTime = halKeySleepTimer();
+        osal_msg_send(registeredKeysTaskID, (uint8 *)msg);
+    }
+}
+#endif /* HAL_KEY_BATCH */
+
+#if HAL_KEY_ENC_COUNT
+/**************************************************************************************************
+ * @fn      halKeyEncoderConfig
+ *
+ * @brief   Configure encoder pins as pulled-up inputs, interrupt on pin A
+ *
+ * @param   None
+ *
+ * @return  None
+ **************************************************************************************************/
+static void halKeyEncoderConfig(void)
+{
+    uint8 i;
+    uint8 levels;
+
+#if HAL_KEY_ENC1_PINS(0) | HAL_KEY_ENC2_PINS(0)
+    P0SEL &= ~(HAL_KEY_ENC1_PINS(0) | HAL_KEY_ENC2_PINS(0));
+    P0DIR &= ~(HAL_KEY_ENC1_PINS(0) | HAL_KEY_ENC2_PINS(0));
+    P0INP &= ~(HAL_KEY_ENC1_PINS(0) | HAL_KEY_ENC2_PINS(0));
+    P2INP &= ~HAL_KEY_BIT5; // pull up
+    P0IEN |= HAL_KEY_P0_ENC_PINS;
+    IEN1 |= HAL_KEY_BIT5;   // enable port0 int
+#endif
+
+#if HAL_KEY_ENC1_PINS(1) | HAL_KEY_ENC2_PINS(1)
+    P1SEL &= ~(HAL_KEY_ENC1_PINS(1) | HAL_KEY_ENC2_PINS(1));
+    P1DIR &= ~(HAL_KEY_ENC1_PINS(1) | HAL_KEY_ENC2_PINS(1));
+    P1INP &= ~(HAL_KEY_ENC1_PINS(1) | HAL_KEY_ENC2_PINS(1));
+    P2INP &= ~HAL_KEY_BIT6; // pull up
+    P1IEN |= HAL_KEY_P1_ENC_PINS;
+    IEN2 |= HAL_KEY_BIT4;   // enable port1 int
+#endif
+
+#if HAL_KEY_ENC1_PINS(2) | HAL_KEY_ENC2_PINS(2)
+    P2SEL &= ~(HAL_KEY_ENC1_PINS(2) | HAL_KEY_ENC2_PINS(2));
+    P2DIR &= ~(HAL_KEY_ENC1_PINS(2) | HAL_KEY_ENC2_PINS(2));
+    P2INP &= ~(HAL_KEY_ENC1_PINS(2) | HAL_KEY_ENC2_PINS(2));
+    P2INP &= ~HAL_KEY_BIT7; // pull up
+    P2IEN |= HAL_KEY_P2_ENC_PINS;
+    IEN2 |= HAL_KEY_BIT1;   // enable port2 int
+#endif
+
+    MicroWait(50);
+
+    for (i = 0; i < HAL_KEY_ENC_COUNT; i++)
+    {
+        levels = (halKeyEncCfg[i].port == HAL_KEY_PORT0) ? P0 :
+                 (halKeyEncCfg[i].port == HAL_KEY_PORT1) ? P1 : P2;
+        halKeyEnc[i].lastA = (levels & halKeyEncCfg[i].pinA) ? 1 : 0;
+        halKeyEnc[i].position = 0;
+        halKeyEnc[i].delta = 0;
+        // next edge is opposite to current level
+        if (halKeyEnc[i].lastA)
+            PICTL |= halKeyEncCfg[i].edge;
+        else
+            PICTL &= ~halKeyEncCfg[i].edge;
+    }
+}
+
+/**************************************************************************************************
+ * @fn      halKeyEncoderIsr
+ *
+ * @brief   Decode encoders of the port, called from port ISR
+ *
+ * @param   port - HAL_KEY_PORTx
+ *          levels - port pins state
+ *
+ * @return  None
+ **************************************************************************************************/
+static void halKeyEncoderIsr(uint8 port, uint8 levels)
+{
+    uint8 i, a;
+    int8 step;
+
+    for (i = 0; i < HAL_KEY_ENC_COUNT; i++)
+    {
+        if (halKeyEncCfg[i].port != port)
+            continue;
+
+        a = (levels & halKeyEncCfg[i].pinA) ? 1 : 0;
+        step = halKeyEncTable[(halKeyEnc[i].lastA << 2) | (a << 1) | ((levels & halKeyEncCfg[i].pinB) != 0)];
+        halKeyEnc[i].lastA = a;
+
+        if (a)
+            PICTL |= halKeyEncCfg[i].edge;
+        else
+            PICTL &= ~halKeyEncCfg[i].edge;
+
+        if (step)
+        {
+            halKeyEnc[i].position += step;
+            halKeyEnc[i].delta += step;
+            if (!(halKeyPending & HAL_KEY_PENDING_ENC))
+            {
+                halKeyPending |= HAL_KEY_PENDING_ENC;
+                halKeyArmEvent(HAL_KEY_ENC_REPORT_RATE);
+            }
+        }
+    }
+}
+
+/**************************************************************************************************
+ * @fn      halKeyEncoderReport
+ *
+ * @brief   Send coalesced encoder deltas to the registered keys task
+ *
+ * @param   None
+ *
+ * @return  None
+ **************************************************************************************************/
+static void halKeyEncoderReport(void)
+{
+    halKeyEncoderChange_t *msg;
+    halIntState_t intState;
+    int16 delta, position;
+    uint8 i;
+
+    for (i = 0; i < HAL_KEY_ENC_COUNT; i++)
+    {
+        HAL_ENTER_CRITICAL_SECTION(intState);
+        delta = halKeyEnc[i].delta;
+        position = halKeyEnc[i].position;
+        halKeyEnc[i].delta = 0;
+        HAL_EXIT_CRITICAL_SECTION(intState);
+
+        if (delta == 0 || registeredKeysTaskID == NO_TASK_ID)
+            continue;
+
+        msg = (halKeyEncoderChange_t *)osal_msg_allocate(sizeof(halKeyEncoderChange_t));
+        if (msg)
+        {
+            msg->hdr.event = HAL_KEY_ENCODER_CHANGE;
+            msg->hdr.status = 0;
+            msg->encoder = i;
+            msg->delta = delta;
+            msg->position = position;
+            osal_msg_send(registeredKeysTaskID, (uint8 *)msg);
+        }
+    }
+}
+
+/**************************************************************************************************
+ * @fn      HalKeyEncoderRead
+ *
+ * @brief   Read encoder position
+ *
+ * @param   encoder - encoder index
+ *
+ * @return  accumulated steps
+ **************************************************************************************************/
+int16 HalKeyEncoderRead(uint8 encoder)
+{
+    halIntState_t intState;
+    int16 position;
+
+    if (encoder >= HAL_KEY_ENC_COUNT)
+        return 0;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    position = halKeyEnc[encoder].position;
+    HAL_EXIT_CRITICAL_SECTION(intState);
+
+    return position;
+}
+
+/**************************************************************************************************
+ * @fn      HalKeyEncoderReset
+ *
+ * @brief   Set encoder position
+ *
+ * @param   encoder - encoder index
+ *          position - new position
+ *
+ * @return  None
+ **************************************************************************************************/
+void HalKeyEncoderReset(uint8 encoder, int16 position)
+{
+    halIntState_t intState;
+
+    if (encoder >= HAL_KEY_ENC_COUNT)
+        return;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    halKeyEnc[encoder].position = position;
+    halKeyEnc[encoder].delta = 0;
+    HAL_EXIT_CRITICAL_SECTION(intState);
+}
+#else
+int16 HalKeyEncoderRead(uint8 encoder) { return 0; }
+void HalKeyEncoderReset(uint8 encoder, int16 position) {}
+#endif /* HAL_KEY_ENC_COUNT */
+
+#if HAL_KEY_CNT_COUNT
+/**************************************************************************************************
+ * @fn      halKeyCounterIsr
+ *
+ * @brief   Count pulses of the port, called from port ISR
+ *
+ * @param   pins - flagged counter pins
+ *          mask - counter pins of the port
+ *          cnt - counters of the port
+ *
+ * @return  None
+ **************************************************************************************************/
+static void halKeyCounterIsr(uint8 pins, uint8 mask, halKeyCnt_t *cnt)
+{
+    uint32 now = halKeySleepTimer(); // 24 bit, a 16 bit slice wraps every 2s
+    uint8 bit;
+
+    for (bit = 0x01; bit; bit <<= 1)
+    {
+        if (!(mask & bit))
+            continue;
+
+        if ((pins & bit) && ((now - cnt->last) & 0x00FFFFFF) >= HAL_KEY_COUNTER_MIN_INTERVAL)
+        {
+            cnt->last = now;
+            cnt->total++;
+#if HAL_KEY_COUNTER_REPORT_THRESHOLD
+            if (cnt->total - cnt->reported >= HAL_KEY_COUNTER_REPORT_THRESHOLD &&
+                !(halKeyPending & HAL_KEY_PENDING_CNT))
+            {
+                halKeyPending |= HAL_KEY_PENDING_CNT;
+                halKeyArmEvent(1);
+            }
+#endif
+        }
+        cnt++;
+    }
+}
+
+/**************************************************************************************************
+ * @fn      halKeyCounterPoll
+ *
+ * @brief   Send counter reports when due and schedule the next periodic one
+ *
+ * @param   threshold - report threshold reached
+ *
+ * @return  None
+ **************************************************************************************************/
+static void halKeyCounterPoll(bool threshold)
+{
+    static const uint8 masks[3] = { HAL_KEY_P0_COUNTER_PINS, HAL_KEY_P1_COUNTER_PINS, HAL_KEY_P2_COUNTER_PINS };
+    halKeyCounterReport_t *msg;
+    halKeyCnt_t *cnt = halKeyCnt;
+    halIntState_t intState;
+    uint32 now = osal_GetSystemClock();
+    uint32 total, elapsed;
+    uint8 port, bit;
+    bool periodic = false;
+
+#if HAL_KEY_COUNTER_REPORT_INTERVAL
+    periodic = (now - halKeyCntReportTime) >= HAL_KEY_COUNTER_REPORT_INTERVAL;
+    if (periodic)
+        halKeyCntReportTime = now;
+#endif
+
+    for (port = 0; (periodic || threshold) && port < 3; port++)
+    {
+        for (bit = 0x01; bit; bit <<= 1)
+        {
+            if (!(masks[port] & bit))
+                continue;
+
+            HAL_ENTER_CRITICAL_SECTION(intState);
+            total = cnt->total;
+            HAL_EXIT_CRITICAL_SECTION(intState);
+
+            if ((periodic || total != cnt->reported) && registeredKeysTaskID != NO_TASK_ID)
+            {
+                msg = (halKeyCounterReport_t *)osal_msg_allocate(sizeof(halKeyCounterReport_t));
+                if (msg)
+                {
+                    // frequency in 0.1 Hz units, split to avoid pulses * 10000 overflow
+                    elapsed = now - cnt->reportTime;
+                    if (elapsed == 0)
+                        elapsed = 1;
+                    msg->hdr.event = HAL_KEY_COUNTER_REPORT;
+                    msg->hdr.status = 0;
+                    msg->port = BV(port);
+                    msg->pin = bit;
+                    msg->total = total;
+                    msg->frequency = (total - cnt->reported) / elapsed * 10000UL +
+                                     (total - cnt->reported) % elapsed * 10000UL / elapsed;
+                    osal_msg_send(registeredKeysTaskID, (uint8 *)msg);
+
+                    HAL_ENTER_CRITICAL_SECTION(intState);
+                    cnt->reported = total;
+                    HAL_EXIT_CRITICAL_SECTION(intState);
+                    cnt->reportTime = now;
+                }
+            }
+            cnt++;
+        }
+    }
+
+#if HAL_KEY_COUNTER_REPORT_INTERVAL
+    halKeyArmEvent(HAL_KEY_COUNTER_REPORT_INTERVAL - (now - halKeyCntReportTime));
+#endif
+}
+
+/**************************************************************************************************
+ * @fn      HalKeyCounterRead
+ *
+ * @brief   Read pulse counter
+ *
+ * @param   port - HAL_KEY_PORTx
+ *          pin - pin mask
+ *
+ * @return  pulses counted, 0 if pin is not a counter
+ **************************************************************************************************/
+uint32 HalKeyCounterRead(uint8 port, uint8 pin)
+{
+    halIntState_t intState;
+    uint8 mask, bit, i;
+    uint32 total;
+
+    switch (port)
+    {
+    case HAL_KEY_PORT0:
+        mask = HAL_KEY_P0_COUNTER_PINS;
+        i = HAL_KEY_P0_CNT_BASE;
+        break;
+    case HAL_KEY_PORT1:
+        mask = HAL_KEY_P1_COUNTER_PINS;
+        i = HAL_KEY_P1_CNT_BASE;
+        break;
+    case HAL_KEY_PORT2:
+        mask = HAL_KEY_P2_COUNTER_PINS;
+        i = HAL_KEY_P2_CNT_BASE;
+        break;
+    default:
+        return 0;
+    }
+
+    if (!(mask & pin))
+        return 0;
+
+    for (bit = 0x01; bit != pin; bit <<= 1)
+    {
+        if (mask & bit)
+            i++;
+    }
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    total = halKeyCnt[i].total;
+    HAL_EXIT_CRITICAL_SECTION(intState);
+
+    return total;
+}
+#else
+uint32 HalKeyCounterRead(uint8 port, uint8 pin) { return 0; }
+#endif /* HAL_KEY_CNT_COUNT */
+
+#if HAL_KEY_STORM_THRESHOLD
+/**************************************************************************************************
+ * @fn      halKeyStormIsr
+ *
+ * @brief   Measure key interrupt rate of the port, mask key pins interrupts and switch
+ *          to sampling when rate exceeds HAL_KEY_STORM_THRESHOLD. Called from port ISR.
+ *
+ * @param   port - port number (0..2)
+ *
+ * @return  TRUE if port is throttled and interrupt is not to be processed
+ **************************************************************************************************/
+static bool halKeyStormIsr(uint8 port)
+{
+    halKeyStorm_t *st = &halKeyStorm[port];
+    uint16 now;
+
+    if (st->throttled)
+        return TRUE; // flag of masked pin
+
+    halKeyStormStats[port].interrupts++;
+
+    now = ST0; // ST0 read latches ST1
+    now |= (uint16)ST1 << 8;
+
+    if ((uint16)(now - st->windowStart) >= HAL_KEY_STORM_WINDOW)
+    {
+        st->windowStart = now;
+        st->count = 0;
+    }
+
+    if (++st->count <= HAL_KEY_STORM_THRESHOLD)
+        return FALSE;
+
+    switch (port)
+    {
+    case 0:
+        P0IEN &= ~HAL_KEY_P0_KEY_PINS;
+        st->levels = P0 & HAL_KEY_P0_KEY_PINS;
+        break;
+    case 1:
+        P1IEN &= ~HAL_KEY_P1_KEY_PINS;
+        st->levels = P1 & HAL_KEY_P1_KEY_PINS;
+        break;
+    default:
+        P2IEN &= ~HAL_KEY_P2_KEY_PINS;
+        st->levels = P2 & HAL_KEY_P2_KEY_PINS;
+        break;
+    }
+
+    st->throttled = TRUE;
+    st->stable = 0;
+    halKeyStormStats[port].storms++;
+
+    halKeyPending |= HAL_KEY_PENDING_STORM;
+    halKeyArmEvent(HAL_KEY_STORM_POLL_PERIOD);
+
+    return TRUE;
+}
+
+/**************************************************************************************************
+ * @fn      halKeyStormPoll
+ *
+ * @brief   Sample throttled ports, report changes and re-enable interrupts once settled
+ *
+ * @param   None
+ *
+ * @return  None
+ **************************************************************************************************/
+static void halKeyStormPoll(void)
+{
+    halKeyStorm_t *st;
+    uint8 port, levels, changed;
+#if !HAL_KEY_BATCH
+    uint8 pressed;
+#endif
+    bool sampling = FALSE;
+
+    for (port = 0; port < 3; port++)
+    {
+        st = &halKeyStorm[port];
+        if (!st->throttled)
+            continue;
+
+        levels = (port == 0) ? P0 : (port == 1) ? P1 : P2;
+        levels &= halKeyPins[port];
+        changed = levels ^ st->levels;
+        halKeyStormStats[port].samples++;
+
+        if (changed)
+        {
+            st->levels = levels;
+            st->stable = 0;
+#if HAL_KEY_BATCH
+            halKeyBatchAdd(port, changed);
+#else
+            pressed = halKeyPressed(port, levels) & changed;
+            if (pressed)
+                OnBoard_SendKeys(pressed, HAL_KEY_PRESS | BV(port));
+            if (changed & ~pressed)
+                OnBoard_SendKeys(changed & ~pressed, HAL_KEY_RELEASE | BV(port));
+#endif
+        }
+        else if (++st->stable >= HAL_KEY_STORM_SETTLE)
+        {
+            halKeySetEdge(port, halKeyPressed(port, levels));
+
+            st->throttled = FALSE;
+            st->count = 0;
+            switch (port)
+            {
+            case 0:
+                P0IFG = ~HAL_KEY_P0_KEY_PINS;
+                P0IEN |= HAL_KEY_P0_KEY_PINS;
+                break;
+            case 1:
+                P1IFG = ~HAL_KEY_P1_KEY_PINS;
+                P1IEN |= HAL_KEY_P1_KEY_PINS;
+                break;
+            default:
+                P2IFG = ~HAL_KEY_P2_KEY_PINS;
+                P2IEN |= HAL_KEY_P2_KEY_PINS;
+                break;
+            }
+            continue;
+        }
+        sampling = TRUE;
+    }
+
+    if (sampling)
+    {
+        halKeyPending |= HAL_KEY_PENDING_STORM;
+        halKeyArmEvent(HAL_KEY_STORM_POLL_PERIOD);
+    }
+}
+
+/**************************************************************************************************
+ * @fn      HalKeyStormStats
+ *
+ * @brief   Read interrupt storm diagnostics of the port
+ *
+ * @param   port - HAL_KEY_PORTx
+ *          stats - target structure
+ *
+ * @return  TRUE if port is currently throttled
+ **************************************************************************************************/
+bool HalKeyStormStats(uint8 port, halKeyStormStats_t *stats)
+{
+    halIntState_t intState;
+    uint8 i = (port == HAL_KEY_PORT0) ? 0 : (port == HAL_KEY_PORT1) ? 1 : 2;
+
+    if (stats != NULL)
+    {
+        HAL_ENTER_CRITICAL_SECTION(intState);
+        *stats = halKeyStormStats[i];
+        HAL_EXIT_CRITICAL_SECTION(intState);
+    }
+
+    return halKeyStorm[i].throttled;
+}
+#else
+bool HalKeyStormStats(uint8 port, halKeyStormStats_t *stats) { return FALSE; }
+#endif /* HAL_KEY_STORM_THRESHOLD */
+
+#if HAL_KEY_MATRIX
+/**************************************************************************************************
+ * @fn      halKeyMatrixIdle
+ *
+ * @brief   Drive all rows low and wait for column interrupt
+ *
+ * @param   None
+ *
+ * @return  None
+ **************************************************************************************************/
+static void halKeyMatrixIdle(void)
+{
+    HAL_KEY_SFR(HAL_KEY_MATRIX_ROW_PORT, DIR) |= HAL_KEY_MATRIX_ROW_PINS;
+    MicroWait(HAL_KEY_MATRIX_SETTLE);
+    PICTL |= IO_EDGE_BIT(HAL_KEY_MATRIX_COL_PORT, 0) | IO_EDGE_BIT(HAL_KEY_MATRIX_COL_PORT, 7);
+    HAL_KEY_SFR(HAL_KEY_MATRIX_COL_PORT, IFG) = ~HAL_KEY_MATRIX_COL_PINS;
+    HAL_KEY_SFR(HAL_KEY_MATRIX_COL_PORT, IEN) |= HAL_KEY_MATRIX_COL_PINS;
+}
+
+/**************************************************************************************************
+ * @fn      halKeyMatrixIsr
+ *
+ * @brief   Key pressed in idle state: mask columns and start scanning. Called from port ISR.
+ *
+ * @param   None
+ *
+ * @return  None
+ **************************************************************************************************/
+static void halKeyMatrixIsr(void)
+{
+    HAL_KEY_SFR(HAL_KEY_MATRIX_COL_PORT, IEN) &= ~HAL_KEY_MATRIX_COL_PINS;
+    halKeyPending |= HAL_KEY_PENDING_MATRIX;
+    halKeyArmEvent(HAL_KEY_MATRIX_SCAN_PERIOD);
+}
+
+/**************************************************************************************************
+ * @fn      halKeyMatrixScan
+ *
+ * @brief   Drive rows one by one and read columns. Keys sharing two columns in two rows
+ *          are ambiguous (ghosting), new presses of such scan are ignored.
+ *
+ * @param   None
+ *
+ * @return  pressed keys, bit = row * columns + column
+ **************************************************************************************************/
+static uint32 halKeyMatrixScan(void)
+{
+    uint32 keys = 0;
+    uint32 bit = 1;
+    uint8 rowCols[8];
+    uint8 rows = 0;
+    uint8 row, col, cols, i, j;
+    bool ghost = FALSE;
+
+    for (row = 0x01; row; row <<= 1)
+    {
+        if (!(HAL_KEY_MATRIX_ROW_PINS & row))
+            continue;
+
+        // only this row is driven low, others are pulled up inputs
+        HAL_KEY_SFR(HAL_KEY_MATRIX_ROW_PORT, DIR) =
+            (HAL_KEY_SFR(HAL_KEY_MATRIX_ROW_PORT, DIR) & ~HAL_KEY_MATRIX_ROW_PINS) | row;
+        MicroWait(HAL_KEY_MATRIX_SETTLE);
+        cols = ~HAL_KEY_PORT_SFR(HAL_KEY_MATRIX_COL_PORT) & HAL_KEY_MATRIX_COL_PINS;
+        rowCols[rows++] = cols;
+
+        for (col = 0x01; col; col <<= 1)
+        {
+            if (!(HAL_KEY_MATRIX_COL_PINS & col))
+                continue;
+            if (cols & col)
+                keys |= bit;
+            bit <<= 1;
+        }
+    }
+
+    for (i = 0; i < rows && !ghost; i++)
+    {
+        for (j = i + 1; j < rows; j++)
+        {
+            cols = rowCols[i] & rowCols[j];
+            if (cols & (cols - 1)) // two or more common columns
+            {
+                ghost = TRUE;
+                break;
+            }
+        }
+    }
+
+    // only releases are trusted when ghosting is possible
+    return ghost ? (keys & halKeyMatrixState) : keys;
+}
+
+/**************************************************************************************************
+ * @fn      halKeyMatrixPoll
+ *
+ * @brief   Scan, debounce over two scans, report changes, go idle when all released
+ *
+ * @param   None
+ *
+ * @return  None
+ **************************************************************************************************/
+static void halKeyMatrixPoll(void)
+{
+    halKeyMatrixChange_t *msg;
+    uint32 keys = halKeyMatrixScan();
+
+    if (keys == halKeyMatrixLast && keys != halKeyMatrixState)
+    {
+        if (registeredKeysTaskID != NO_TASK_ID)
+        {
+            msg = (halKeyMatrixChange_t *)osal_msg_allocate(sizeof(halKeyMatrixChange_t));
+            if (msg)
+            {
+                msg->hdr.event = HAL_KEY_MATRIX_CHANGE;
+                msg->hdr.status = 0;
+                msg->changed = keys ^ halKeyMatrixState;
+                msg->state = keys;
+                osal_msg_send(registeredKeysTaskID, (uint8 *)msg);
+            }
+        }
+        halKeyMatrixState = keys;
+    }
+    halKeyMatrixLast = keys;
+
+    if (keys == 0 && halKeyMatrixState == 0)
+    {
+        halKeyMatrixIdle();
+        return;
+    }
+
+    halKeyPending |= HAL_KEY_PENDING_MATRIX;
+    halKeyArmEvent(HAL_KEY_MATRIX_SCAN_PERIOD);
+}
+
+/**************************************************************************************************
+ * @fn      HalKeyMatrixRead
+ *
+ * @brief   Read debounced keypad state
+ *
+ * @param   None
+ *
+ * @return  pressed keys, bit = row * columns + column
+ **************************************************************************************************/
+uint32 HalKeyMatrixRead(void)
+{
+    return halKeyMatrixState;
+}
+#else
+uint32 HalKeyMatrixRead(void) { return 0; }
+#endif /* HAL_KEY_MATRIX */
+
+/***************************************************************************************************
+ *                                    INTERRUPT SERVICE ROUTINE
+ ***************************************************************************************************/
+
+/*
+ * Port ISR body, specialized per port: masks and edge bits are constants, steps of
+ * disabled features and pin groups absent on the port expand to nothing.
+ * PxIFG is read once, flags of edges arriving meanwhile are kept and PxIF is set
+ * again for them, as PxIF is not raised by flags left pending in PxIFG.
+ */
+#if HAL_KEY_LATENCY_STATS
+  #define HAL_KEY_ISR_STATS(n) halKeyLatency[n].isrCount++
+#else
+  #define HAL_KEY_ISR_STATS(n)
+#endif
+
+#if HAL_KEY_ENC_COUNT
+  #define HAL_KEY_ISR_ENC(n, flags)                                           \
+    if (HAL_KEY_P##n##_ENC_PINS && ((flags) & HAL_KEY_P##n##_ENC_PINS))       \
+        halKeyEncoderIsr(HAL_KEY_PORT##n, P##n)
+#else
+  #define HAL_KEY_ISR_ENC(n, flags)
+#endif
+
+#if HAL_KEY_CNT_COUNT
+  #define HAL_KEY_ISR_CNT(n, flags)                                           \
+    if (HAL_KEY_P##n##_COUNTER_PINS && ((flags) & HAL_KEY_P##n##_COUNTER_PINS)) \
+        halKeyCounterIsr((flags) & HAL_KEY_P##n##_COUNTER_PINS,               \
+                         HAL_KEY_P##n##_COUNTER_PINS, &halKeyCnt[HAL_KEY_P##n##_CNT_BASE])
+#else
+  #define HAL_KEY_ISR_CNT(n, flags)
+#endif
+
+#if HAL_KEY_STORM_THRESHOLD
+  #define HAL_KEY_ISR_THROTTLED(n) halKeyStormIsr(n)
+#else
+  #define HAL_KEY_ISR_THROTTLED(n) FALSE
+#endif
+
+#if HAL_KEY_MATRIX
+  #define HAL_KEY_ISR_MATRIX() halKeyMatrixIsr()
+#else
+  #define HAL_KEY_ISR_MATRIX()
+#endif
+
+#define HAL_KEY_PORT_ISR(n, flags)                                            \
+    st(                                                                       \
+        HAL_ACTIVE_BEGIN(activeStart);                                        \
+        flags = P##n##IFG;                                                    \
+        IO_TRACE(n, flags);                                                   \
+        HAL_KEY_ISR_STATS(n);                                                 \
+        HAL_KEY_ISR_ENC(n, flags);                                            \
+        HAL_KEY_ISR_CNT(n, flags);                                            \
+        if (HAL_KEY_P##n##_KEY_PINS && ((flags) & HAL_KEY_P##n##_KEY_PINS))  \
+        {                                                                     \
+            if (HAL_KEY_IS_MATRIX(n))                                         \
+            {                                                                 \
+                HAL_KEY_ISR_MATRIX();                                         \
+            }                                                                 \
+            else if (!HAL_KEY_ISR_THROTTLED(n))                               \
+            {                                                                 \
+                halProcessKeyInterrupt(HAL_KEY_PORT##n, (flags) & HAL_KEY_P##n##_KEY_PINS); \
+            }                                                                 \
+        }                                                                     \
+        P##n##IFG = ~(flags);                                                 \
+        P##n##IF = 0;                                                         \
+        if (P##n##IFG & P##n##IEN) /* edge after sampling, rerun the ISR */   \
+            P##n##IF = 1;                                                     \
+        HAL_ACTIVE_END(HAL_ACTIVE_KEY_ISR, activeStart);                      \
+    )
+
+/**************************************************************************************************
+ * @fn      halKeyPort0Isr
+ *
+ * @brief   Port0 ISR
+ *
+ * @param
+ *
+ * @return
+ **************************************************************************************************/
+#if HAL_KEY_P0_INPUT_PINS || HAL_KEY_P0_ENC_PINS
+HAL_ISR_FUNCTION(halKeyPort0Isr, P0INT_VECTOR)
+{
+    uint8 flags;
+
+    HAL_ENTER_ISR();
+
+    HAL_KEY_PORT_ISR(0, flags);
+
+    CLEAR_SLEEP_MODE();
+    HAL_EXIT_ISR();
+}
+#endif /* HAL_KEY_P0_INPUT_PINS || HAL_KEY_P0_ENC_PINS */
+
+/**************************************************************************************************
+ * @fn      halKeyPort1Isr
+ *
+ * @brief   Port1 ISR
+ *
+ * @param
+ *
+ * @return
+ **************************************************************************************************/
+#if HAL_KEY_P1_INPUT_PINS || HAL_KEY_P1_ENC_PINS
+HAL_ISR_FUNCTION(halKeyPort1Isr, P1INT_VECTOR)
+{
+    uint8 flags;
+
+    HAL_ENTER_ISR();
+
+    HAL_KEY_PORT_ISR(1, flags);
+
+    CLEAR_SLEEP_MODE();
+    HAL_EXIT_ISR();
+}
+#endif /* HAL_KEY_P1_INPUT_PINS || HAL_KEY_P1_ENC_PINS */
+
+/**************************************************************************************************
+ * @fn      halKeyPort2Isr
+ *
+ * @brief   Port2 ISR
+ *
+ * @param
+ *
+ * @return
+ **************************************************************************************************/
+#if HAL_KEY_P2_INPUT_PINS || HAL_KEY_P2_ENC_PINS
+HAL_ISR_FUNCTION(halKeyPort2Isr, P2INT_VECTOR)
+{
+    uint8 flags;
+
+    HAL_ENTER_ISR();
 
-    P2IFG = 0; //&= ~HAL_KEY_P2_INPUT_PINS;
-    P2IF = 0;
+    HAL_KEY_PORT_ISR(2, flags);
 
     CLEAR_SLEEP_MODE();
     HAL_EXIT_ISR();
 }
-#endif /* HAL_KEY_P2_INPUT_PINS */
+#endif /* HAL_KEY_P2_INPUT_PINS || HAL_KEY_P2_ENC_PINS */
 
 #else /* !HAL_KEY */
 
@@ -393,5 +1897,12 @@ void HalKeyInit(void) {}
 void HalKeyConfig(bool interruptEnable, halKeyCBack_t cback) {}
 uint8 HalKeyRead(void) { return 0; }
 void HalKeyPoll(void) {}
+int16 HalKeyEncoderRead(uint8 encoder) { return 0; }
+void HalKeyEncoderReset(uint8 encoder, int16 position) {}
+uint32 HalKeyCounterRead(uint8 port, uint8 pin) { return 0; }
+bool HalKeyStormStats(uint8 port, halKeyStormStats_t *stats) { return FALSE; }
+void HalKeyLatencyStats(uint8 port, halKeyLatencyStats_t *stats, bool reset) {}
+void HalKeySleepStats(halKeySleepStats_t *stats) {}
+uint32 HalKeyMatrixRead(void) { return 0; }
 
 #endif /* !HAL_KEY */
@@ -21,6 +21,7 @@ extern "C"
  *                                             INCLUDES
  **************************************************************************************************/
 #include "hal_board.h"
+#include "OSAL.h"
   
 /**************************************************************************************************
  * MACROS
@@ -65,11 +66,91 @@ extern "C"
 #define HAL_KEY_SW_6 0x20  // Button S1 if available
 #define HAL_KEY_SW_7 0x40  // Button S2 if available
 
+/* OSAL event of encoder delta message sent to the registered keys task */
+#ifndef HAL_KEY_ENCODER_CHANGE
+#define HAL_KEY_ENCODER_CHANGE 0xC8
+#endif
+
+/* OSAL event of pulse counter report sent to the registered keys task */
+#ifndef HAL_KEY_COUNTER_REPORT
+#define HAL_KEY_COUNTER_REPORT 0xC9
+#endif
+
+/* OSAL event of batched key changes sent to the registered keys task */
+#ifndef HAL_KEY_BATCH_CHANGE
+#define HAL_KEY_BATCH_CHANGE 0xCA
+#endif
+
+/* OSAL event of keypad matrix changes sent to the registered keys task */
+#ifndef HAL_KEY_MATRIX_CHANGE
+#define HAL_KEY_MATRIX_CHANGE 0xCB
+#endif
+
 /**************************************************************************************************
  * TYPEDEFS
  **************************************************************************************************/
 typedef void (*halKeyCBack_t) (uint8 keys, uint8 state);
 
+typedef struct
+{
+    osal_event_hdr_t hdr; // HAL_KEY_ENCODER_CHANGE
+    uint8 encoder;        // encoder index
+    int16 delta;          // steps since previous message
+    int16 position;       // accumulated steps
+} halKeyEncoderChange_t;
+
+typedef struct
+{
+    osal_event_hdr_t hdr; // HAL_KEY_COUNTER_REPORT
+    uint8 port;           // HAL_KEY_PORTx
+    uint8 pin;            // pin mask
+    uint32 total;         // pulses counted
+    uint32 frequency;     // since previous report, 0.1 Hz units
+} halKeyCounterReport_t;
+
+typedef struct
+{
+    uint32 interrupts; // key interrupts processed
+    uint16 storms;     // times port was throttled
+    uint32 samples;    // samples taken while throttled
+} halKeyStormStats_t;
+
+typedef struct
+{
+    osal_event_hdr_t hdr; // HAL_KEY_BATCH_CHANGE
+    uint8 changed[3];     // changed pins of port 0..2
+    uint8 state[3];       // pressed pins of port 0..2
+    uint32 edgeTime[3];   // sleep timer at first edge of port 0..2, 0 if unchanged
+    uint32 pollTime;      // sleep timer at delivery
+} halKeyBatchChange_t;
+
+typedef struct
+{
+    uint32 isrCount;   // port interrupts
+    uint32 events;     // key events delivered
+    uint32 latencyMin; // first edge to delivery, us
+    uint32 latencyAvg;
+    uint32 latencyMax;
+} halKeyLatencyStats_t;
+
+typedef struct
+{
+    uint16 sleeps;    // HalKeyEnterSleep calls
+    uint16 switches;  // clock switches performed
+    uint16 skipped;   // clock switches skipped as not required
+    uint16 spinMax;   // max CLKCONSTA wait loop iterations
+    uint32 spinTotal; // total CLKCONSTA wait loop iterations
+    uint16 wakeLast;  // last HalKeyExitSleep wake to ready latency, us
+    uint16 wakeMax;   // max HalKeyExitSleep wake to ready latency, us
+} halKeySleepStats_t;
+
+typedef struct
+{
+    osal_event_hdr_t hdr; // HAL_KEY_MATRIX_CHANGE
+    uint32 changed;       // changed keys, bit = row * columns + column
+    uint32 state;         // pressed keys
+} halKeyMatrixChange_t;
+
 /**************************************************************************************************
  *                                             GLOBAL VARIABLES
  **************************************************************************************************/
@@ -118,6 +199,41 @@ extern uint8 hal_key_keys( void );
 
 extern uint8 hal_key_int_keys( void );
 
+/*
+ * Read rotary encoder position
+ */
+extern int16 HalKeyEncoderRead( uint8 encoder );
+
+/*
+ * Set rotary encoder position
+ */
+extern void HalKeyEncoderReset( uint8 encoder, int16 position );
+
+/*
+ * Read pulse counter of HAL_KEY_Px_COUNTER_PINS pin
+ */
+extern uint32 HalKeyCounterRead( uint8 port, uint8 pin );
+
+/*
+ * Read interrupt storm diagnostics, returns TRUE while port is throttled
+ */
+extern bool HalKeyStormStats( uint8 port, halKeyStormStats_t *stats );
+
+/*
+ * Read ISR counts and key event latency statistics
+ */
+extern void HalKeyLatencyStats( uint8 port, halKeyLatencyStats_t *stats, bool reset );
+
+/*
+ * Read sleep transitions statistics
+ */
+extern void HalKeySleepStats( halKeySleepStats_t *stats );
+
+/*
+ * Read keypad matrix state
+ */
+extern uint32 HalKeyMatrixRead( void );
+
 /**************************************************************************************************
 **************************************************************************************************/
 
@@ -0,0 +1,389 @@
+/**************************************************************************************************
+  Filename:       hal_onewire.c
+
+  Revision:       20230128
+
+  Description:    Software 1-Wire master interface driver
+
+**************************************************************************************************/
+
+#include "hal_defs.h"
+#include "hal_mcu.h"
+#include "hal_gpio_defs.h"
+#include "hal_onewire.h"
+#include "OnBoard.h" // MicroWait()
+
+// *************************   MACROS   ************************************
+
+// the default cofiguration below uses P0.7 for DQ.
+// change these as needed.
+#ifndef OW_PORT
+#define OW_PORT 0
+#endif
+
+#ifndef OW_PIN
+#define OW_PIN 7
+#endif
+
+// Standard speed timings, us
+#define OW_T_RSTL   480  // reset low
+#define OW_T_MSP    70   // reset release to presence sample
+#define OW_T_RSTH   410  // presence to reset end
+#define OW_T_LOW1   6    // write 1 / read low
+#define OW_T_LOW0   60   // write 0 low
+#define OW_T_MSR    9    // read release to sample
+#define OW_T_REC    10   // recovery after write 0
+#define OW_T_READ   55   // slot remainder after read sample
+
+// OW port I/O, open-drain via direction register
+#define OW_STATE    IO_PIN(OW_PORT, OW_PIN) // 0 for LOW, not 0 for HIGH
+#define OW_LOW()    st( IO_DIR_PORT_PIN(OW_PORT, OW_PIN, IO_OUT); IO_PIN(OW_PORT, OW_PIN) = 0; )
+#define OW_RELEASE() IO_DIR_PORT_PIN(OW_PORT, OW_PIN, IO_IN)
+
+// ************************* DECLARATIONS **********************************
+
+static  uint8_t HalOneWireBit(uint8_t bit);
+static inline void HalOneWireWriteByte(uint8_t value);
+static inline uint8_t HalOneWireReadByte(void);
+static int8_t HalOneWireSearchFail(halOneWireSearch_t *state, int8_t ret);
+
+/* PRIVATE */
+
+/*********************************************************************
+ * @fn      HalOneWireBit
+ * @brief   Performs one time slot, interrupts are masked within the
+ *          slot only. Read slot is a write 1 slot.
+ * @param   bit - bit to write, 1 to read
+ * @return  bit read
+ */
+static uint8_t HalOneWireBit(uint8_t bit)
+{
+    halIntState_t intState;
+    uint8_t rval;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    OW_LOW();
+    if (bit)
+    {
+        MicroWait(OW_T_LOW1);
+        OW_RELEASE();
+        MicroWait(OW_T_MSR);
+        rval = OW_STATE != 0;
+        HAL_EXIT_CRITICAL_SECTION(intState);
+        MicroWait(OW_T_READ);
+    }
+    else
+    {
+        MicroWait(OW_T_LOW0);
+        OW_RELEASE();
+        HAL_EXIT_CRITICAL_SECTION(intState);
+        MicroWait(OW_T_REC);
+        rval = 0;
+    }
+
+    return rval;
+}
+
+/*********************************************************************
+ * @fn      HalOneWireWriteByte
+ * @brief   Sends one byte, LSB first
+ * @param   value - data byte to send
+ * @return  none
+ */
+static inline void HalOneWireWriteByte(uint8_t value)
+{
+    uint8_t i;
+
+    for (i = 0; i < 8; i++)
+    {
+        HalOneWireBit(value & 0x01);
+        value >>= 1;
+    }
+}
+
+/*********************************************************************
+ * @fn      HalOneWireReadByte
+ * @brief   Receives one byte, LSB first
+ * @param   none
+ * @return  byte read
+ */
+static inline uint8_t HalOneWireReadByte(void)
+{
+    uint8_t i, rval = 0;
+
+    for (i = 0; i < 8; i++)
+    {
+        rval >>= 1;
+        if (HalOneWireBit(1))
+            rval |= 0x80;
+    }
+
+    return rval;
+}
+
+/*********************************************************************
+ * @fn      HalOneWireSearchFail
+ * @brief   Clears search state, next search starts from first device
+ * @param   state - search state
+ * @param   ret - error to return
+ * @return  ret
+ */
+static int8_t HalOneWireSearchFail(halOneWireSearch_t *state, int8_t ret)
+{
+    state->lastDiscrepancy = 0;
+    state->lastDevice = 0;
+    return ret;
+}
+
+/*********************************************************************
+**********************************************************************/
+
+/* PUBLIC */
+
+/*********************************************************************
+ * @fn      HalOneWireInit
+ * @brief   Initializes 1-Wire bus pin
+ * @param   void
+ * @return  void
+ */
+void HalOneWireInit(void)
+{
+    IO_PIN(OW_PORT, OW_PIN) = 0;
+    IO_CFG_PORT_MASK(OW_PORT, BV(OW_PIN), IO_GIO, IO_IN, IO_PUD);
+}
+
+/*********************************************************************
+ * @fn      HalOneWireReset
+ * @brief   Sends reset pulse and detects presence pulse
+ * @param   void
+ * @return  OW_SUCCESS when device is present, otherwise OW_E_*
+ */
+int8_t HalOneWireReset(void)
+{
+    halIntState_t intState;
+    uint8_t presence;
+
+    if (!OW_STATE)
+        return OW_E_SHORT;
+
+    // longer reset low is harmless, interrupts stay enabled
+    OW_LOW();
+    MicroWait(OW_T_RSTL);
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    OW_RELEASE();
+    MicroWait(OW_T_MSP);
+    presence = !OW_STATE;
+    HAL_EXIT_CRITICAL_SECTION(intState);
+
+    MicroWait(OW_T_RSTH);
+
+    if (!OW_STATE)
+        return OW_E_SHORT;
+
+    return presence ? OW_SUCCESS : OW_E_NODEV;
+}
+
+/*********************************************************************
+ * @fn      HalOneWireWrite
+ * @brief   Sends buffer contents
+ * @param   buffer - ptr to buffered data to send
+ * @param   len - number of bytes in the buffer
+ * @return  void
+ */
+void HalOneWireWrite(const uint8_t *buffer, uint8_t len)
+{
+    while (len--)
+        HalOneWireWriteByte(*buffer++);
+}
+
+/*********************************************************************
+ * @fn      HalOneWireRead
+ * @brief   Receives data into a buffer
+ * @param   buffer - target array for received data
+ * @param   len - number of bytes to read
+ * @return  void
+ */
+void HalOneWireRead(uint8_t *buffer, uint8_t len)
+{
+    while (len--)
+        *buffer++ = HalOneWireReadByte();
+}
+
+/*********************************************************************
+ * @fn      HalOneWireSelect
+ * @brief   Resets bus and addresses device
+ * @param   rom - device ROM code, NULL to address all devices (Skip ROM)
+ * @return  OW_SUCCESS when successful, otherwise OW_E_*
+ */
+int8_t HalOneWireSelect(const uint8_t *rom)
+{
+    int8_t ret;
+
+    ret = HalOneWireReset();
+    if (ret != OW_SUCCESS)
+        return ret;
+
+    if (rom == NULL)
+    {
+        HalOneWireWriteByte(OW_CMD_SKIP_ROM);
+    }
+    else
+    {
+        HalOneWireWriteByte(OW_CMD_MATCH_ROM);
+        HalOneWireWrite(rom, OW_ROM_LEN);
+    }
+
+    return OW_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      HalOneWireSearch
+ * @brief   Finds next device ROM code (Maxim AN187 search algorithm)
+ * @param   state - search state, rom is set to found device
+ * @return  OW_SUCCESS when device found, OW_E_NODEV when no more devices,
+ *          otherwise OW_E_*
+ */
+int8_t HalOneWireSearch(halOneWireSearch_t *state)
+{
+    uint8_t bitNum, byteNum, mask;
+    uint8_t idBit, cmpBit, dir;
+    uint8_t lastZero = 0;
+    int8_t ret;
+
+    if (state == NULL)
+        return OW_E_INVAL;
+
+    if (state->lastDevice)
+        return OW_E_NODEV;
+
+    ret = HalOneWireReset();
+    if (ret != OW_SUCCESS)
+        return HalOneWireSearchFail(state, ret);
+
+    HalOneWireWriteByte(OW_CMD_SEARCH_ROM);
+
+    for (bitNum = 1; bitNum <= OW_ROM_LEN * 8; bitNum++)
+    {
+        byteNum = (bitNum - 1) >> 3;
+        mask = BV((bitNum - 1) & 0x07);
+
+        idBit = HalOneWireBit(1);
+        cmpBit = HalOneWireBit(1);
+
+        if (idBit && cmpBit) // no device responded
+            return HalOneWireSearchFail(state, OW_E_NODEV);
+
+        if (idBit != cmpBit)
+            dir = idBit;
+        else if (bitNum < state->lastDiscrepancy)
+            dir = (state->rom[byteNum] & mask) != 0;
+        else
+            dir = (bitNum == state->lastDiscrepancy);
+
+        if (!idBit && !cmpBit && !dir)
+            lastZero = bitNum;
+
+        if (dir)
+            state->rom[byteNum] |= mask;
+        else
+            state->rom[byteNum] &= ~mask;
+
+        HalOneWireBit(dir);
+    }
+
+    state->lastDiscrepancy = lastZero;
+    if (!lastZero)
+        state->lastDevice = 1;
+
+    if (HalOneWireCrc8(state->rom, OW_ROM_LEN) != 0)
+        return HalOneWireSearchFail(state, OW_E_CRC);
+
+    return OW_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      HalOneWireConvert
+ * @brief   Starts temperature conversion and returns immediately
+ * @param   rom - device ROM code, NULL to start all devices at once
+ * @return  OW_SUCCESS when successful, otherwise OW_E_*
+ */
+int8_t HalOneWireConvert(const uint8_t *rom)
+{
+    int8_t ret;
+
+    ret = HalOneWireSelect(rom);
+    if (ret != OW_SUCCESS)
+        return ret;
+
+    HalOneWireWriteByte(OW_CMD_CONVERT_T);
+
+    return OW_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      HalOneWireConvertDone
+ * @brief   Checks conversion state with one read slot, devices hold
+ *          the bus low while converting
+ * @param   void
+ * @return  TRUE when all started conversions are complete
+ */
+uint8_t HalOneWireConvertDone(void)
+{
+    return HalOneWireBit(1);
+}
+
+/*********************************************************************
+ * @fn      HalOneWireReadScratchpad
+ * @brief   Reads and checks device scratchpad
+ * @param   rom - device ROM code, NULL for single device on bus
+ * @param   buffer - OW_SCRATCH_LEN bytes target
+ * @return  OW_SUCCESS when successful, otherwise OW_E_*
+ */
+int8_t HalOneWireReadScratchpad(const uint8_t *rom, uint8_t *buffer)
+{
+    int8_t ret;
+
+    if (buffer == NULL)
+        return OW_E_INVAL;
+
+    ret = HalOneWireSelect(rom);
+    if (ret != OW_SUCCESS)
+        return ret;
+
+    HalOneWireWriteByte(OW_CMD_READ_SCRATCH);
+    HalOneWireRead(buffer, OW_SCRATCH_LEN);
+
+    if (HalOneWireCrc8(buffer, OW_SCRATCH_LEN) != 0)
+        return OW_E_CRC;
+
+    return OW_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      HalOneWireCrc8
+ * @brief   Calculates Maxim CRC8 (x^8 + x^5 + x^4 + 1)
+ * @param   data - data to check
+ * @param   len - number of bytes
+ * @return  CRC, 0 when data includes valid CRC byte
+ */
+uint8_t HalOneWireCrc8(const uint8_t *data, uint8_t len)
+{
+    uint8_t crc = 0;
+    uint8_t i, b;
+
+    while (len--)
+    {
+        b = *data++;
+        for (i = 0; i < 8; i++)
+        {
+            if ((crc ^ b) & 0x01)
+                crc = (crc >> 1) ^ 0x8C;
+            else
+                crc >>= 1;
+            b >>= 1;
+        }
+    }
+
+    return crc;
+}
@@ -0,0 +1,126 @@
+/**************************************************************************************************
+  Filename:       hal_onewire.h
+
+  Revision:       20230128
+
+  Description:    Software 1-Wire master interface driver
+
+**************************************************************************************************/
+
+#ifndef HAL_ONEWIRE_H
+#define HAL_ONEWIRE_H
+
+enum {
+    OW_SUCCESS = 0,
+    OW_E_NODEV,       // No presence pulse after reset, or search finished
+    OW_E_SHORT,       // Bus held low
+    OW_E_CRC,         // CRC mismatch
+    OW_E_INVAL        // Invalid argument
+};
+
+// ROM and function commands
+#define OW_CMD_SEARCH_ROM     0xF0
+#define OW_CMD_MATCH_ROM      0x55
+#define OW_CMD_SKIP_ROM       0xCC
+#define OW_CMD_CONVERT_T      0x44
+#define OW_CMD_READ_SCRATCH   0xBE
+
+#define OW_ROM_LEN            8
+#define OW_SCRATCH_LEN        9
+
+// ROM search state, zero initialized state starts new search
+typedef struct
+{
+    uint8_t rom[OW_ROM_LEN];  // last found device
+    uint8_t lastDiscrepancy;  // bit position of last unresolved branch, 0 - none
+    uint8_t lastDevice;       // set after last device was found
+} halOneWireSearch_t;
+
+/*********************************************************************
+ * @fn      HalOneWireInit
+ * @brief   Initializes 1-Wire bus pin
+ * @param   void
+ * @return  void
+ */
+void    HalOneWireInit( void );
+
+/*********************************************************************
+ * @fn      HalOneWireReset
+ * @brief   Sends reset pulse and detects presence pulse
+ * @param   void
+ * @return  OW_SUCCESS when device is present, otherwise OW_E_*
+ */
+int8_t  HalOneWireReset( void );
+
+/*********************************************************************
+ * @fn      HalOneWireWrite
+ * @brief   Sends buffer contents
+ * @param   buffer - ptr to buffered data to send
+ * @param   len - number of bytes in the buffer
+ * @return  void
+ */
+void    HalOneWireWrite( const uint8_t *buffer, uint8_t len );
+
+/*********************************************************************
+ * @fn      HalOneWireRead
+ * @brief   Receives data into a buffer
+ * @param   buffer - target array for received data
+ * @param   len - number of bytes to read
+ * @return  void
+ */
+void    HalOneWireRead( uint8_t *buffer, uint8_t len );
+
+/*********************************************************************
+ * @fn      HalOneWireSelect
+ * @brief   Resets bus and addresses device
+ * @param   rom - device ROM code, NULL to address all devices (Skip ROM)
+ * @return  OW_SUCCESS when successful, otherwise OW_E_*
+ */
+int8_t  HalOneWireSelect( const uint8_t *rom );
+
+/*********************************************************************
+ * @fn      HalOneWireSearch
+ * @brief   Finds next device ROM code, state is cleared on errors
+ *          so the next call starts a new search
+ * @param   state - search state, rom is set to found device
+ * @return  OW_SUCCESS when device found, OW_E_NODEV when no more devices,
+ *          otherwise OW_E_*
+ */
+int8_t  HalOneWireSearch( halOneWireSearch_t *state );
+
+/*********************************************************************
+ * @fn      HalOneWireConvert
+ * @brief   Starts temperature conversion and returns immediately
+ * @param   rom - device ROM code, NULL to start all devices at once
+ * @return  OW_SUCCESS when successful, otherwise OW_E_*
+ */
+int8_t  HalOneWireConvert( const uint8_t *rom );
+
+/*********************************************************************
+ * @fn      HalOneWireConvertDone
+ * @brief   Checks conversion state with one read slot, to be polled
+ *          from OSAL timer event. Not usable with parasite power.
+ * @param   void
+ * @return  TRUE when all started conversions are complete
+ */
+uint8_t HalOneWireConvertDone( void );
+
+/*********************************************************************
+ * @fn      HalOneWireReadScratchpad
+ * @brief   Reads and checks device scratchpad
+ * @param   rom - device ROM code, NULL for single device on bus
+ * @param   buffer - OW_SCRATCH_LEN bytes target
+ * @return  OW_SUCCESS when successful, otherwise OW_E_*
+ */
+int8_t  HalOneWireReadScratchpad( const uint8_t *rom, uint8_t *buffer );
+
+/*********************************************************************
+ * @fn      HalOneWireCrc8
+ * @brief   Calculates Maxim CRC8 (x^8 + x^5 + x^4 + 1)
+ * @param   data - data to check
+ * @param   len - number of bytes
+ * @return  CRC, 0 when data includes valid CRC byte
+ */
+uint8_t HalOneWireCrc8( const uint8_t *data, uint8_t len );
+
+#endif /* HAL_ONEWIRE_H */
@@ -0,0 +1,223 @@
+/**************************************************************************************************
+  Filename:       hal_sspi.c
+
+  Revision:       20230128
+
+  Description:    Software SPI master interface driver
+
+**************************************************************************************************/
+
+#include "hal_defs.h"
+#include "hal_gpio_defs.h"
+#include "hal_sspi.h"
+#include "OnBoard.h" // MicroWait()
+
+// *************************   MACROS   ************************************
+
+#if !defined SSPI_MODE                 // SPI mode 0..3: bit 1 - CPOL, bit 0 - CPHA
+#define SSPI_MODE 0
+#endif
+
+#if SSPI_MODE > 3
+#error "SSPI_MODE must be 0..3"
+#endif
+
+#define SSPI_CPOL ((SSPI_MODE >> 1) & 1)  // SCK idle level
+#define SSPI_CPHA (SSPI_MODE & 1)         // 0 - sample on leading edge, 1 - on trailing edge
+
+// the default cofiguration below uses P1.5 for SCK, P1.6 for MOSI and P1.7 for MISO.
+// change these as needed.
+#ifndef SSPI_SCK_PORT
+#define SSPI_SCK_PORT 1
+#endif
+#ifndef SSPI_SCK_PIN
+#define SSPI_SCK_PIN 5
+#endif
+
+#ifndef SSPI_MOSI_PORT
+#define SSPI_MOSI_PORT 1
+#endif
+#ifndef SSPI_MOSI_PIN
+#define SSPI_MOSI_PIN 6
+#endif
+
+#ifndef SSPI_MISO_PORT
+#define SSPI_MISO_PORT 1
+#endif
+#ifndef SSPI_MISO_PIN
+#define SSPI_MISO_PIN 7
+#endif
+
+// Half period delay, none by default for maximum speed
+#ifndef SSPI_HPERIOD
+#define SSPI_HPERIOD()
+#endif
+
+// SSPI port I/O, bit addressable pins
+#define SSPI_SCK   IO_PIN(SSPI_SCK_PORT, SSPI_SCK_PIN)
+#define SSPI_MOSI  IO_PIN(SSPI_MOSI_PORT, SSPI_MOSI_PIN)
+#define SSPI_MISO  IO_PIN(SSPI_MISO_PORT, SSPI_MISO_PIN)
+
+// One bit, MSB first
+#if SSPI_CPHA == 0
+#define SSPI_BIT_TX(out, bit)                             \
+    st(                                                   \
+        SSPI_MOSI = ((out) & BV(bit)) != 0;               \
+        SSPI_HPERIOD();                                   \
+        SSPI_SCK = !SSPI_CPOL;                            \
+        SSPI_HPERIOD();                                   \
+        SSPI_SCK = SSPI_CPOL;                             \
+    )
+#define SSPI_BIT_XFER(out, in, bit)                       \
+    st(                                                   \
+        SSPI_MOSI = ((out) & BV(bit)) != 0;               \
+        SSPI_HPERIOD();                                   \
+        SSPI_SCK = !SSPI_CPOL;                            \
+        if (SSPI_MISO)                                    \
+            in |= BV(bit);                                \
+        SSPI_HPERIOD();                                   \
+        SSPI_SCK = SSPI_CPOL;                             \
+    )
+#else
+#define SSPI_BIT_TX(out, bit)                             \
+    st(                                                   \
+        SSPI_SCK = !SSPI_CPOL;                            \
+        SSPI_MOSI = ((out) & BV(bit)) != 0;               \
+        SSPI_HPERIOD();                                   \
+        SSPI_SCK = SSPI_CPOL;                             \
+        SSPI_HPERIOD();                                   \
+    )
+#define SSPI_BIT_XFER(out, in, bit)                       \
+    st(                                                   \
+        SSPI_SCK = !SSPI_CPOL;                            \
+        SSPI_MOSI = ((out) & BV(bit)) != 0;               \
+        SSPI_HPERIOD();                                   \
+        SSPI_SCK = SSPI_CPOL;                             \
+        if (SSPI_MISO)                                    \
+            in |= BV(bit);                                \
+        SSPI_HPERIOD();                                   \
+    )
+#endif
+
+// ************************* DECLARATIONS **********************************
+
+static inline uint8_t HalSSpiXfer(uint8_t value);
+static inline    void HalSSpiTx(uint8_t value);
+
+/* PRIVATE */
+
+/*********************************************************************
+ * @fn      HalSSpiXfer
+ * @brief   Shifts one byte out and in, unrolled
+ * @param   value - byte to send
+ * @return  byte received
+ */
+static inline uint8_t HalSSpiXfer(uint8_t value)
+{
+    uint8_t rval = 0;
+
+    SSPI_BIT_XFER(value, rval, 7);
+    SSPI_BIT_XFER(value, rval, 6);
+    SSPI_BIT_XFER(value, rval, 5);
+    SSPI_BIT_XFER(value, rval, 4);
+    SSPI_BIT_XFER(value, rval, 3);
+    SSPI_BIT_XFER(value, rval, 2);
+    SSPI_BIT_XFER(value, rval, 1);
+    SSPI_BIT_XFER(value, rval, 0);
+
+    return rval;
+}
+
+/*********************************************************************
+ * @fn      HalSSpiTx
+ * @brief   Shifts one byte out, unrolled, MISO ignored
+ * @param   value - byte to send
+ * @return  none
+ */
+static inline void HalSSpiTx(uint8_t value)
+{
+    SSPI_BIT_TX(value, 7);
+    SSPI_BIT_TX(value, 6);
+    SSPI_BIT_TX(value, 5);
+    SSPI_BIT_TX(value, 4);
+    SSPI_BIT_TX(value, 3);
+    SSPI_BIT_TX(value, 2);
+    SSPI_BIT_TX(value, 1);
+    SSPI_BIT_TX(value, 0);
+}
+
+/*********************************************************************
+**********************************************************************/
+
+/* PUBLIC */
+
+/*********************************************************************
+ * @fn      HalSSpiInit
+ * @brief   Initializes SCK, MOSI, MISO pins, SCK is set to idle level
+ * @param   void
+ * @return  void
+ */
+void HalSSpiInit(void)
+{
+    SSPI_SCK = SSPI_CPOL;
+    SSPI_MOSI = 0;
+
+    IO_CFG_PORT_MASK(SSPI_SCK_PORT, BV(SSPI_SCK_PIN), IO_GIO, IO_OUT, IO_PUD);
+    IO_CFG_PORT_MASK(SSPI_MOSI_PORT, BV(SSPI_MOSI_PIN), IO_GIO, IO_OUT, IO_PUD);
+    IO_CFG_PORT_MASK(SSPI_MISO_PORT, BV(SSPI_MISO_PIN), IO_GIO, IO_IN, IO_PUD);
+}
+
+/*********************************************************************
+ * @fn      HalSSpiByte
+ * @brief   Sends and receives one byte
+ * @param   value - byte to send
+ * @return  byte received
+ */
+uint8_t HalSSpiByte(uint8_t value)
+{
+    return HalSSpiXfer(value);
+}
+
+/*********************************************************************
+ * @fn      HalSSpiTransfer
+ * @brief   Full duplex transfer
+ * @param   tx - data to send, NULL to send 0xFF
+ * @param   rx - target for received data, NULL to skip MISO sampling
+ * @param   len - number of bytes
+ * @return  void
+ */
+void HalSSpiTransfer(const uint8_t *tx, uint8_t *rx, uint16_t len)
+{
+    if (rx == NULL)
+    {
+        if (tx != NULL)
+            HalSSpiSend(tx, len);
+        return;
+    }
+
+    if (tx == NULL)
+    {
+        while (len--)
+            *rx++ = HalSSpiXfer(0xFF);
+        return;
+    }
+
+    while (len--)
+        *rx++ = HalSSpiXfer(*tx++);
+}
+
+/*********************************************************************
+ * @fn      HalSSpiSend
+ * @brief   Transmit only burst, MISO is not sampled
+ * @param   tx - data to send
+ * @param   len - number of bytes
+ * @return  void
+ */
+void HalSSpiSend(const uint8_t *tx, uint16_t len)
+{
+    if (tx == NULL)
+        return;
+
+    while (len--)
+        HalSSpiTx(*tx++);
+}
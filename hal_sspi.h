@@ -0,0 +1,48 @@
+/**************************************************************************************************
+  Filename:       hal_sspi.h
+
+  Revision:       20230128
+
+  Description:    Software SPI master interface driver
+
+**************************************************************************************************/
+
+#ifndef HAL_SSPI_H
+#define HAL_SSPI_H
+
+/*********************************************************************
+ * @fn      HalSSpiInit
+ * @brief   Initializes SCK, MOSI, MISO pins, SCK is set to idle level
+ * @param   void
+ * @return  void
+ */
+void    HalSSpiInit( void );
+
+/*********************************************************************
+ * @fn      HalSSpiByte
+ * @brief   Sends and receives one byte
+ * @param   value - byte to send
+ * @return  byte received
+ */
+uint8_t HalSSpiByte( uint8_t value );
+
+/*********************************************************************
+ * @fn      HalSSpiTransfer
+ * @brief   Full duplex transfer
+ * @param   tx - data to send, NULL to send 0xFF
+ * @param   rx - target for received data, NULL to skip MISO sampling
+ * @param   len - number of bytes
+ * @return  void
+ */
+void    HalSSpiTransfer( const uint8_t *tx, uint8_t *rx, uint16_t len );
+
+/*********************************************************************
+ * @fn      HalSSpiSend
+ * @brief   Transmit only burst, MISO is not sampled
+ * @param   tx - data to send
+ * @param   len - number of bytes
+ * @return  void
+ */
+void    HalSSpiSend( const uint8_t *tx, uint16_t len );
+
+#endif /* HAL_SSPI_H */
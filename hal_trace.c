@@ -0,0 +1,93 @@
+/**************************************************************************************************
+  Filename:       hal_trace.c
+
+  Revision:       20230128
+
+  Description:    GPIO transition trace recorder
+
+**************************************************************************************************/
+
+#include "hal_defs.h"
+#include "hal_gpio_defs.h"
+
+#if HAL_TRACE
+
+#include "hal_trace.h"
+#include "OSAL.h" // osal_memcpy()
+
+// *************************   GLOBALS   ***********************************
+
+halTraceEntry_t halTraceBuf[HAL_TRACE_SIZE];
+uint8 halTraceHead;    // next entry to write
+uint16 halTraceCount;  // entries recorded, saturated at 0xFFFF
+
+/* PUBLIC */
+
+/*********************************************************************
+ * @fn      HalTraceClear
+ * @brief   Discards recorded entries
+ * @param   void
+ * @return  void
+ */
+void HalTraceClear(void)
+{
+    halIntState_t intState;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    halTraceHead = 0;
+    halTraceCount = 0;
+    HAL_EXIT_CRITICAL_SECTION(intState);
+}
+
+/*********************************************************************
+ * @fn      HalTraceDump
+ * @brief   Copies header and newest entries, oldest first, into buffer.
+ *          Recording is held off while copying.
+ * @param   buffer - target buffer
+ * @param   len - buffer size
+ * @return  bytes written, 0 when buffer can't hold header
+ */
+uint16 HalTraceDump(uint8 *buffer, uint16 len)
+{
+    halIntState_t intState;
+    uint16 entries, lost, first, tail;
+
+    if (len < HAL_TRACE_HDR_LEN)
+        return 0;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+
+    entries = (halTraceCount < HAL_TRACE_SIZE) ? halTraceCount : HAL_TRACE_SIZE;
+    if (entries > (len - HAL_TRACE_HDR_LEN) / sizeof(halTraceEntry_t))
+        entries = (len - HAL_TRACE_HDR_LEN) / sizeof(halTraceEntry_t);
+    lost = halTraceCount - entries;
+
+    buffer[0] = HAL_TRACE_MAGIC0;
+    buffer[1] = HAL_TRACE_MAGIC1;
+    buffer[2] = HAL_TRACE_VERSION;
+    buffer[3] = sizeof(halTraceEntry_t);
+    buffer[4] = BREAK_UINT32(HAL_TRACE_TICK_HZ, 0);
+    buffer[5] = BREAK_UINT32(HAL_TRACE_TICK_HZ, 1);
+    buffer[6] = BREAK_UINT32(HAL_TRACE_TICK_HZ, 2);
+    buffer[7] = BREAK_UINT32(HAL_TRACE_TICK_HZ, 3);
+    buffer[8] = LO_UINT16(entries);
+    buffer[9] = HI_UINT16(entries);
+    buffer[10] = LO_UINT16(lost);
+    buffer[11] = HI_UINT16(lost);
+    buffer += HAL_TRACE_HDR_LEN;
+
+    // ring may wrap: copy [first, end) then [0, head)
+    first = (halTraceHead - entries) & (HAL_TRACE_SIZE - 1);
+    tail = HAL_TRACE_SIZE - first;
+    if (tail > entries)
+        tail = entries;
+    osal_memcpy(buffer, &halTraceBuf[first], tail * sizeof(halTraceEntry_t));
+    osal_memcpy(buffer + tail * sizeof(halTraceEntry_t), halTraceBuf,
+                (entries - tail) * sizeof(halTraceEntry_t));
+
+    HAL_EXIT_CRITICAL_SECTION(intState);
+
+    return HAL_TRACE_HDR_LEN + entries * sizeof(halTraceEntry_t);
+}
+
+#endif /* HAL_TRACE */
@@ -0,0 +1,92 @@
+/**************************************************************************************************
+  Filename:       hal_trace.h
+
+  Revision:       20230128
+
+  Description:    GPIO transition trace recorder
+
+**************************************************************************************************/
+
+#ifndef HAL_TRACE_H
+#define HAL_TRACE_H
+
+#include "hal_types.h"
+#include "hal_mcu.h"
+
+// Ring buffer size in entries, power of 2 up to 256
+#ifndef HAL_TRACE_SIZE
+#define HAL_TRACE_SIZE 64
+#endif
+
+#if (HAL_TRACE_SIZE & (HAL_TRACE_SIZE - 1)) || HAL_TRACE_SIZE > 256
+  #error "HAL_TRACE_SIZE must be a power of 2 up to 256"
+#endif
+
+// Timestamp source, low byte read first latches high byte. Default is sleep timer.
+#ifndef HAL_TRACE_TIME_LO
+#define HAL_TRACE_TIME_LO ST0
+#define HAL_TRACE_TIME_HI ST1
+#endif
+
+#ifndef HAL_TRACE_TICK_HZ
+#define HAL_TRACE_TICK_HZ 32768UL
+#endif
+
+#define HAL_TRACE_MAGIC0   'G'
+#define HAL_TRACE_MAGIC1   'T'
+#define HAL_TRACE_VERSION  1
+#define HAL_TRACE_HDR_LEN  12
+
+typedef struct
+{
+    uint8 timeLo;
+    uint8 timeHi;
+    uint8 port;  // 0..2
+    uint8 mask;  // traced pins
+    uint8 level; // levels of traced pins
+} halTraceEntry_t;
+
+extern halTraceEntry_t halTraceBuf[HAL_TRACE_SIZE];
+extern uint8 halTraceHead;
+extern uint16 halTraceCount;
+
+/*
+ * Record pins level, safe in ISR
+ */
+#define HAL_TRACE_RECORD(_port, _mask, _level)                            \
+    st(                                                                   \
+        halIntState_t _traceIntState;                                     \
+        halTraceEntry_t *_traceEntry;                                     \
+        HAL_ENTER_CRITICAL_SECTION(_traceIntState);                       \
+        _traceEntry = &halTraceBuf[halTraceHead];                         \
+        halTraceHead = (halTraceHead + 1) & (HAL_TRACE_SIZE - 1);         \
+        if (halTraceCount != 0xFFFF)                                      \
+            halTraceCount++;                                              \
+        _traceEntry->timeLo = HAL_TRACE_TIME_LO;                          \
+        _traceEntry->timeHi = HAL_TRACE_TIME_HI;                          \
+        _traceEntry->port = (_port);                                      \
+        _traceEntry->mask = (_mask);                                      \
+        _traceEntry->level = (_level);                                    \
+        HAL_EXIT_CRITICAL_SECTION(_traceIntState);                        \
+    )
+
+/*********************************************************************
+ * @fn      HalTraceClear
+ * @brief   Discards recorded entries
+ * @param   void
+ * @return  void
+ */
+void   HalTraceClear( void );
+
+/*********************************************************************
+ * @fn      HalTraceDump
+ * @brief   Copies header and newest entries, oldest first, into buffer.
+ *          Header: 'G' 'T' version entry_size tick_hz(4) entries(2) lost(2),
+ *          multibyte fields little endian.
+ * @param   buffer - target buffer
+ * @param   len - buffer size
+ * @return  bytes written, 0 when buffer can't hold header
+ */
+uint16 HalTraceDump( uint8 *buffer, uint16 len );
+
+#endif /* HAL_TRACE_H */
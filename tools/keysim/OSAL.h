@@ -0,0 +1,29 @@
+/**************************************************************************************************
+  Filename:       OSAL.h
+
+  Description:    Host simulator stub of OSAL messages and timers, implemented in keysim.c
+
+**************************************************************************************************/
+
+#ifndef OSAL_H
+#define OSAL_H
+
+#include "hal_types.h"
+
+typedef struct
+{
+    uint8 event;
+    uint8 status;
+} osal_event_hdr_t;
+
+uint8 *osal_msg_allocate(uint16 len);
+uint8 osal_msg_deallocate(uint8 *msg);
+uint8 osal_msg_send(uint8 destination_task, uint8 *msg);
+uint8 osal_start_timerEx(uint8 task_id, uint16 event_id, uint32 timeout_value);
+uint8 osal_stop_timerEx(uint8 task_id, uint16 event_id);
+uint32 osal_get_timeoutEx(uint8 task_id, uint16 event_id);
+uint32 osal_GetSystemClock(void);
+void *osal_memset(void *dest, uint8 value, int len);
+void *osal_memcpy(void *dst, const void *src, unsigned int len);
+
+#endif /* OSAL_H */
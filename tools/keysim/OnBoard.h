@@ -0,0 +1,18 @@
+/**************************************************************************************************
+  Filename:       OnBoard.h
+
+  Description:    Host simulator stub, implemented in keysim.c
+
+**************************************************************************************************/
+
+#ifndef ONBOARD_H
+#define ONBOARD_H
+
+#include "hal_mcu.h"
+
+#define NO_TASK_ID 0xFF
+
+void MicroWait(uint16 timeout);
+uint8 OnBoard_SendKeys(uint8 keys, uint8 shift);
+
+#endif /* ONBOARD_H */
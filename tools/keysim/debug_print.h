@@ -0,0 +1,13 @@
+/**************************************************************************************************
+  Filename:       debug_print.h
+
+  Description:    Host simulator stub
+
+**************************************************************************************************/
+
+#ifndef DEBUG_PRINT_H
+#define DEBUG_PRINT_H
+
+#define DBGF(...)
+
+#endif /* DEBUG_PRINT_H */
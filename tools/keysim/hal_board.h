@@ -0,0 +1,13 @@
+/**************************************************************************************************
+  Filename:       hal_board.h
+
+  Description:    Host simulator stub
+
+**************************************************************************************************/
+
+#ifndef HAL_BOARD_H
+#define HAL_BOARD_H
+
+#include "hal_mcu.h"
+
+#endif /* HAL_BOARD_H */
@@ -0,0 +1,21 @@
+/**************************************************************************************************
+  Filename:       hal_defs.h
+
+  Description:    Host simulator stub of Z-Stack HAL definitions
+
+**************************************************************************************************/
+
+#ifndef HAL_DEFS_H
+#define HAL_DEFS_H
+
+#include "hal_types.h"
+
+#define BV(n) (1 << (n))
+#define st(x) do { x } while (__LINE__ == -1)
+
+#define BREAK_UINT32(var, ByteNum) \
+          (uint8)((uint32)(((var) >> ((ByteNum) * 8)) & 0x00FF))
+#define HI_UINT16(a) (((a) >> 8) & 0xFF)
+#define LO_UINT16(a) ((a) & 0xFF)
+
+#endif /* HAL_DEFS_H */
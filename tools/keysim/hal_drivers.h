@@ -0,0 +1,17 @@
+/**************************************************************************************************
+  Filename:       hal_drivers.h
+
+  Description:    Host simulator stub
+
+**************************************************************************************************/
+
+#ifndef HAL_DRIVERS_H
+#define HAL_DRIVERS_H
+
+#include "hal_types.h"
+
+#define HAL_KEY_EVENT 0x0001
+
+extern uint8 Hal_TaskID;
+
+#endif /* HAL_DRIVERS_H */
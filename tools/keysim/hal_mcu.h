@@ -0,0 +1,32 @@
+/**************************************************************************************************
+  Filename:       hal_mcu.h
+
+  Description:    Host simulator stub of CC2530 SFRs and ISR macros,
+                  SFRs are plain variables driven by keysim.c
+
+**************************************************************************************************/
+
+#ifndef HAL_MCU_H
+#define HAL_MCU_H
+
+#include "hal_defs.h"
+
+extern volatile uint8 P0, P1, P2;
+extern volatile uint8 P0DIR, P1DIR, P2DIR, P0SEL, P1SEL, P2SEL, P0INP, P1INP, P2INP;
+extern volatile uint8 P0IEN, P1IEN, P2IEN, P0IFG, P1IFG, P2IFG, P0IF, P1IF, P2IF;
+extern volatile uint8 PICTL, IEN1, IEN2, EA;
+extern volatile uint8 CLKCONCMD, CLKCONSTA, ST0, ST1, ST2;
+
+#define CLKCONCMD_16MHZ 0x49
+#define CLKCONCMD_32MHZ 0x08
+#define OSC_32KHZ       0x00
+
+#define HAL_ENTER_CRITICAL_SECTION(x) st( x = EA; EA = 0; )
+#define HAL_EXIT_CRITICAL_SECTION(x)  st( EA = x; )
+
+#define HAL_ISR_FUNCTION(f, v) void f(void)
+#define HAL_ENTER_ISR()
+#define HAL_EXIT_ISR()
+#define CLEAR_SLEEP_MODE()
+
+#endif /* HAL_MCU_H */
@@ -0,0 +1,32 @@
+/**************************************************************************************************
+  Filename:       hal_types.h
+
+  Description:    Host simulator stub of Z-Stack HAL types
+
+**************************************************************************************************/
+
+#ifndef HAL_TYPES_H
+#define HAL_TYPES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int8_t   int8;
+typedef uint8_t  uint8;
+typedef int16_t  int16;
+typedef uint16_t uint16;
+typedef int32_t  int32;
+typedef uint32_t uint32;
+typedef uint8    bool;
+typedef uint8    halIntState_t;
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+#define true  TRUE
+#define false FALSE
+
+#endif /* HAL_TYPES_H */
@@ -0,0 +1,688 @@
+/**************************************************************************************************
+  Filename:       keysim.c
+
+  Revision:       20230128
+
+  Description:    Host simulator of the hal_key driver. Replays recorded or synthetic
+                  edge traces through the real port ISRs and HalKeyPoll with emulated
+                  SFRs, OSAL timer and message delivery, reports delivered and dropped
+                  events, latency and ISR counts.
+
+**************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hal_key.h"
+#include "hal_drivers.h"
+#include "OnBoard.h"
+
+/**************************************************************************************************
+ *                                              MACROS
+ **************************************************************************************************/
+
+/* Driver configuration defaults, as in hal_key.c */
+#ifndef HAL_KEY_P0_INPUT_PINS
+  #define HAL_KEY_P0_INPUT_PINS 0x00
+#endif
+#ifndef HAL_KEY_P1_INPUT_PINS
+  #define HAL_KEY_P1_INPUT_PINS 0x00
+#endif
+#ifndef HAL_KEY_P2_INPUT_PINS
+  #define HAL_KEY_P2_INPUT_PINS 0x00
+#endif
+#ifndef HAL_KEY_P0_COUNTER_PINS
+  #define HAL_KEY_P0_COUNTER_PINS 0x00
+#endif
+#ifndef HAL_KEY_P1_COUNTER_PINS
+  #define HAL_KEY_P1_COUNTER_PINS 0x00
+#endif
+#ifndef HAL_KEY_P2_COUNTER_PINS
+  #define HAL_KEY_P2_COUNTER_PINS 0x00
+#endif
+#ifndef HAL_KEY_P0_INPUT_PINS_EDGE
+  #define HAL_KEY_P0_INPUT_PINS_EDGE HAL_KEY_FALLING_EDGE
+#endif
+#ifndef HAL_KEY_P1_INPUT_PINS_EDGE
+  #define HAL_KEY_P1_INPUT_PINS_EDGE HAL_KEY_FALLING_EDGE
+#endif
+#ifndef HAL_KEY_P2_INPUT_PINS_EDGE
+  #define HAL_KEY_P2_INPUT_PINS_EDGE HAL_KEY_FALLING_EDGE
+#endif
+
+/*
+ * Keypad matrix keys are simulated as port 3, pin = key bit of halKeyMatrixChange_t.
+ * Columns follow pressed keys of rows driven low, settled on MicroWait().
+ */
+#define KEYSIM_INPUT_PINS(port)  KEYSIM_INPUT_PINS1(port)
+#define KEYSIM_INPUT_PINS1(port) HAL_KEY_P##port##_INPUT_PINS
+#define KEYSIM_MATRIX_PORT 3
+#ifdef HAL_KEY_MATRIX_ROW_PORT
+  #define KEYSIM_MATRIX_COL_PINS    KEYSIM_INPUT_PINS(HAL_KEY_MATRIX_COL_PORT)
+  #define KEYSIM_MATRIX_COLS(port)  ((port) == HAL_KEY_MATRIX_COL_PORT ? KEYSIM_MATRIX_COL_PINS : 0)
+#else
+  #define KEYSIM_MATRIX_COLS(port)  0
+#endif
+#define KEYSIM_KEYS (KEYSIM_MATRIX_PORT * 8 + 32) // port * 8 + pin
+
+/* Transition is expected to be reported when level holds that long */
+#ifndef KEYSIM_DEBOUNCE_US
+  #define KEYSIM_DEBOUNCE_US 25000
+#endif
+
+#define KEYSIM_MAX_EDGES 200000
+#define KEYSIM_TAIL_US   2000000 // run after the last edge
+
+/**************************************************************************************************
+ *                                            TYPEDEFS
+ **************************************************************************************************/
+typedef struct
+{
+    uint64_t t;    // us
+    uint32 seq;    // order of equal timestamps
+    uint8 port;
+    uint8 pin;
+    uint8 level;
+} simEdge_t;
+
+/**************************************************************************************************
+ *                                        GLOBAL VARIABLES
+ **************************************************************************************************/
+
+/* Emulated SFRs */
+volatile uint8 P0, P1, P2;
+volatile uint8 P0DIR, P1DIR, P2DIR, P0SEL, P1SEL, P2SEL, P0INP, P1INP, P2INP;
+volatile uint8 P0IEN, P1IEN, P2IEN, P0IFG, P1IFG, P2IFG, P0IF, P1IF, P2IF;
+volatile uint8 PICTL, IEN1, IEN2, EA = 1;
+volatile uint8 CLKCONCMD = CLKCONCMD_32MHZ, CLKCONSTA = CLKCONCMD_32MHZ, ST0, ST1, ST2;
+
+uint8 Hal_TaskID = 0;
+uint8 registeredKeysTaskID = 1;
+
+/* Port ISRs of unconfigured ports are not compiled by the driver */
+__attribute__((weak)) void halKeyPort0Isr(void) {}
+__attribute__((weak)) void halKeyPort1Isr(void) {}
+__attribute__((weak)) void halKeyPort2Isr(void) {}
+
+/**************************************************************************************************
+ *                                        LOCAL VARIABLES
+ **************************************************************************************************/
+static const uint8 simKeyPins[3] =
+{
+    HAL_KEY_P0_INPUT_PINS & ~HAL_KEY_P0_COUNTER_PINS & ~KEYSIM_MATRIX_COLS(0),
+    HAL_KEY_P1_INPUT_PINS & ~HAL_KEY_P1_COUNTER_PINS & ~KEYSIM_MATRIX_COLS(1),
+    HAL_KEY_P2_INPUT_PINS & ~HAL_KEY_P2_COUNTER_PINS & ~KEYSIM_MATRIX_COLS(2)
+};
+static const uint8 simFallingEdge[3] =
+{
+    HAL_KEY_P0_INPUT_PINS_EDGE == HAL_KEY_FALLING_EDGE,
+    HAL_KEY_P1_INPUT_PINS_EDGE == HAL_KEY_FALLING_EDGE,
+    HAL_KEY_P2_INPUT_PINS_EDGE == HAL_KEY_FALLING_EDGE
+};
+
+static volatile uint8 *const simIfg[3] = { &P0IFG, &P1IFG, &P2IFG };
+static uint8 simIfgLatch[3]; // PxIFG as held by hardware
+static simEdge_t simEdges[KEYSIM_MAX_EDGES];
+static uint32 simEdgeCount;
+
+static uint64_t simNow;          // us
+static int64_t simDeadline = -1; // HAL_KEY_EVENT timer, us
+static uint32 simSeed = 1;
+
+static uint32 simIsr[3];
+static uint32 simPolls;
+static uint32 simKeyMsgs, simBatchMsgs, simEncMsgs, simCntMsgs, simMatrixMsgs;
+
+static uint8 simMatrixKeys;     // rows * columns
+static uint32 simMatrixPressed; // key bits
+
+/* per port * 8 + pin */
+static uint32 simExpected[KEYSIM_KEYS];
+static uint32 simDelivered[KEYSIM_KEYS];
+static uint64_t simFirstEdge[KEYSIM_KEYS]; // 0 when no edge since last delivery
+
+static uint64_t simLatSum;
+static uint32 simLatMin = 0xFFFFFFFF, simLatMax, simLatCount;
+
+/**************************************************************************************************
+ *                                        FUNCTIONS - Local
+ **************************************************************************************************/
+
+static uint32 simRand(uint32 range)
+{
+    simSeed = simSeed * 1103515245 + 12345;
+    return ((simSeed >> 16) & 0x7FFF) % range;
+}
+
+static void simUpdateSleepTimer(void)
+{
+    uint32 ticks = (uint32)(simNow * 32768 / 1000000);
+
+    ST0 = (uint8)ticks;
+    ST1 = (uint8)(ticks >> 8);
+    ST2 = (uint8)(ticks >> 16);
+}
+
+static volatile uint8 *simPort(uint8 port)
+{
+    return (port == 0) ? &P0 : (port == 1) ? &P1 : &P2;
+}
+
+#ifdef HAL_KEY_MATRIX_ROW_PORT
+static volatile uint8 *simDir(uint8 port)
+{
+    return (port == 0) ? &P0DIR : (port == 1) ? &P1DIR : &P2DIR;
+}
+#endif
+
+/* Key pin of a port, or matrix key */
+static uint8 simIsKey(uint8 port, uint8 pin)
+{
+    return (port == KEYSIM_MATRIX_PORT) ? (pin < simMatrixKeys) : (simKeyPins[port] & BV(pin)) != 0;
+}
+
+static void simDeliverKey(uint8 i)
+{
+    uint32 lat;
+
+    simDelivered[i]++;
+    if (simFirstEdge[i])
+    {
+        lat = (uint32)(simNow - simFirstEdge[i]);
+        simFirstEdge[i] = 0;
+        simLatSum += lat;
+        simLatCount++;
+        if (lat < simLatMin)
+            simLatMin = lat;
+        if (lat > simLatMax)
+            simLatMax = lat;
+    }
+}
+
+static void simDeliver(uint8 port, uint8 pins)
+{
+    uint8 pin;
+
+    for (pin = 0; pin < 8; pin++)
+        if (pins & BV(pin))
+            simDeliverKey(port * 8 + pin);
+}
+
+/* PxIFG bits are cleared by writing 0, writing 1 has no effect */
+static void simIfgSync(void)
+{
+    uint8 port;
+
+    for (port = 0; port < 3; port++)
+    {
+        simIfgLatch[port] &= *simIfg[port];
+        *simIfg[port] = simIfgLatch[port];
+    }
+}
+
+static void simMatrixSettle(void);
+
+/* Apply pin level, raise PxIFG on the selected edge and run the port ISR */
+static void simSetPin(uint8 port, uint8 pin, uint8 level)
+{
+    static volatile uint8 *const ien[3] = { &P0IEN, &P1IEN, &P2IEN };
+    static void (*const isr[3])(void) = { halKeyPort0Isr, halKeyPort1Isr, halKeyPort2Isr };
+    volatile uint8 *px = simPort(port);
+    uint8 bit = BV(pin);
+    uint8 edgeBit, falling, portIe;
+
+    if (port == KEYSIM_MATRIX_PORT)
+    {
+        if (!!(simMatrixPressed & (1UL << pin)) == level)
+            return;
+        simMatrixPressed ^= 1UL << pin;
+        if (!simFirstEdge[port * 8 + pin])
+            simFirstEdge[port * 8 + pin] = simNow ? simNow : 1;
+        simMatrixSettle();
+        return;
+    }
+
+    if (!!(*px & bit) == level)
+        return;
+
+    if (level)
+        *px |= bit;
+    else
+        *px &= ~bit;
+
+    if ((simKeyPins[port] & bit) && !simFirstEdge[port * 8 + pin])
+        simFirstEdge[port * 8 + pin] = simNow ? simNow : 1;
+
+    edgeBit = (port == 0) ? 0x01 : (port == 2) ? 0x08 : (pin < 4) ? 0x02 : 0x04;
+    falling = (PICTL & edgeBit) != 0;
+    if (falling == level)
+        return; // not the selected edge
+
+    simIfgLatch[port] |= bit;
+    *simIfg[port] = simIfgLatch[port];
+    portIe = (port == 0) ? (IEN1 & 0x20) : (port == 1) ? (IEN2 & 0x10) : (IEN2 & 0x02);
+    if ((*ien[port] & bit) && portIe)
+    {
+        // driver sets PxIF again for enabled flags still pending, PxIF itself is not emulated
+        do
+        {
+            simIsr[port]++;
+            isr[port]();
+            simIfgSync();
+        } while (simIfgLatch[port] & *ien[port]);
+    }
+}
+
+/* Column is low when a pressed key connects it to a row driven low */
+static void simMatrixSettle(void)
+{
+#ifdef HAL_KEY_MATRIX_ROW_PORT
+    uint8 driven = *simDir(HAL_KEY_MATRIX_ROW_PORT) & ~*simPort(HAL_KEY_MATRIX_ROW_PORT) &
+                   HAL_KEY_MATRIX_ROW_PINS;
+    uint8 low = 0;
+    uint8 row, col, pin;
+    uint32 bit = 1;
+
+    for (row = 0x01; row; row <<= 1)
+    {
+        if (!(HAL_KEY_MATRIX_ROW_PINS & row))
+            continue;
+        for (col = 0x01; col; col <<= 1)
+        {
+            if (!(KEYSIM_MATRIX_COL_PINS & col))
+                continue;
+            if ((simMatrixPressed & bit) && (driven & row))
+                low |= col;
+            bit <<= 1;
+        }
+    }
+    for (pin = 0; pin < 8; pin++)
+        if (KEYSIM_MATRIX_COL_PINS & BV(pin))
+            simSetPin(HAL_KEY_MATRIX_COL_PORT, pin, !(low & BV(pin)));
+#endif
+}
+
+/* Fire HAL_KEY_EVENT timer until t */
+static void simRunUntil(uint64_t t)
+{
+    while (simDeadline >= 0 && (uint64_t)simDeadline <= t)
+    {
+        simNow = (uint64_t)simDeadline;
+        simUpdateSleepTimer();
+        simDeadline = -1;
+        simPolls++;
+        HalKeyPoll();
+        simIfgSync();
+    }
+    simNow = t;
+    simUpdateSleepTimer();
+}
+
+static void simAddEdge(uint64_t t, uint8 port, uint8 pin, uint8 level)
+{
+    if (simEdgeCount >= KEYSIM_MAX_EDGES)
+        return;
+    simEdges[simEdgeCount].t = t;
+    simEdges[simEdgeCount].seq = simEdgeCount;
+    simEdges[simEdgeCount].port = port;
+    simEdges[simEdgeCount].pin = pin;
+    simEdges[simEdgeCount].level = level;
+    simEdgeCount++;
+}
+
+static int simEdgeCmp(const void *a, const void *b)
+{
+    const simEdge_t *ea = a, *eb = b;
+
+    if (ea->t != eb->t)
+        return ea->t < eb->t ? -1 : 1;
+    return ea->seq < eb->seq ? -1 : 1;
+}
+
+/* Pressed / released level of a key pin, matrix key level is pressed state */
+static uint8 simLevel(uint8 port, uint8 pressed)
+{
+    return (port != KEYSIM_MATRIX_PORT && simFallingEdge[port]) ? !pressed : pressed;
+}
+
+/* Level change with up to 5 bounces within 3ms, returns settle time */
+static uint64_t simBouncyEdge(uint64_t t, uint8 port, uint8 pin, uint8 pressed)
+{
+    uint32 bounces = simRand(6);
+
+    while (bounces--)
+    {
+        simAddEdge(t, port, pin, simLevel(port, pressed));
+        t += 50 + simRand(500);
+        simAddEdge(t, port, pin, simLevel(port, !pressed));
+        t += 50 + simRand(500);
+    }
+    simAddEdge(t, port, pin, simLevel(port, pressed));
+    return t;
+}
+
+static uint64_t simGenBounce(uint64_t t, uint32 count)
+{
+    uint8 port, pin;
+    uint32 n;
+
+    for (port = 0; port <= KEYSIM_MATRIX_PORT; port++)
+        for (pin = 0; pin < 32; pin++)
+        {
+            if (!simIsKey(port, pin))
+                continue;
+            for (n = 0; n < count; n++)
+            {
+                t = simBouncyEdge(t, port, pin, TRUE) + 100000;
+                t = simBouncyEdge(t, port, pin, FALSE) + 200000;
+            }
+        }
+    return t;
+}
+
+static uint64_t simGenBurst(uint64_t t, uint32 count)
+{
+    uint8 port, pin, pressed;
+    uint32 n;
+
+    for (n = 0; n < count * 2; n++)
+    {
+        pressed = !(n & 1);
+        for (port = 0; port <= KEYSIM_MATRIX_PORT; port++)
+            for (pin = 0; pin < 32; pin++)
+                if (simIsKey(port, pin))
+                    simAddEdge(t + simRand(20), port, pin, simLevel(port, pressed));
+        t += pressed ? 100000 : 200000;
+    }
+    return t;
+}
+
+static uint64_t simGenChatter(uint64_t t, uint32 count)
+{
+    uint8 port, pin;
+    uint64_t end;
+    uint8 pressed = FALSE;
+
+    for (port = 0; port < KEYSIM_MATRIX_PORT && !simKeyPins[port]; port++)
+        ;
+    if (port == KEYSIM_MATRIX_PORT && !simMatrixKeys)
+        return t;
+    for (pin = 0; !simIsKey(port, pin); pin++)
+        ;
+
+    // floating input for count * 50ms, then a clean press to check recovery
+    for (end = t + (uint64_t)count * 50000; t < end; t += 200 + simRand(400))
+    {
+        pressed = !pressed;
+        simAddEdge(t, port, pin, simLevel(port, pressed));
+    }
+    simAddEdge(t, port, pin, simLevel(port, FALSE));
+    t += 2000000;
+    simAddEdge(t, port, pin, simLevel(port, TRUE));
+    t += 100000;
+    simAddEdge(t, port, pin, simLevel(port, FALSE));
+    return t + 200000;
+}
+
+/* Trace file: "<time us> <port> <pin> <level>" per line, '#' comments, matrix key is port 3 */
+static int simLoadTrace(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[128];
+    unsigned long long t;
+    unsigned port, pin, level;
+
+    if (f == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f))
+    {
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line, "%llu %u %u %u", &t, &port, &pin, &level) == 4 && ((port < 3 && pin < 8) || (port == KEYSIM_MATRIX_PORT && pin < simMatrixKeys)))
+            simAddEdge(t, (uint8)port, (uint8)pin, level != 0);
+    }
+    fclose(f);
+    return 0;
+}
+
+/* Transitions holding for the debounce time are expected to be delivered */
+static void simExpect(void)
+{
+    uint8 level[KEYSIM_KEYS], stable[KEYSIM_KEYS];
+    uint64_t since[KEYSIM_KEYS];
+    uint32 e;
+    uint8 i;
+
+    for (i = 0; i < KEYSIM_KEYS; i++)
+    {
+        if (i < KEYSIM_MATRIX_PORT * 8)
+            level[i] = stable[i] = !!(*simPort(i / 8) & BV(i % 8));
+        else
+            level[i] = stable[i] = 0; // matrix key released
+        since[i] = 0;
+    }
+
+    for (e = 0; e <= simEdgeCount; e++)
+    {
+        uint64_t t = (e < simEdgeCount) ? simEdges[e].t : (uint64_t)-1;
+
+        for (i = 0; i < KEYSIM_KEYS; i++)
+        {
+            if (level[i] != stable[i] && t - since[i] >= KEYSIM_DEBOUNCE_US && t >= since[i])
+            {
+                stable[i] = level[i];
+                if (i < KEYSIM_MATRIX_PORT * 8 ? simIsKey(i / 8, i % 8) : simIsKey(KEYSIM_MATRIX_PORT, i - KEYSIM_MATRIX_PORT * 8))
+                    simExpected[i]++;
+            }
+        }
+        if (e < simEdgeCount)
+        {
+            i = simEdges[e].port * 8 + simEdges[e].pin;
+            if (level[i] != simEdges[e].level)
+            {
+                level[i] = simEdges[e].level;
+                since[i] = t;
+            }
+        }
+    }
+}
+
+/**************************************************************************************************
+ *                                        FUNCTIONS - Stubs
+ **************************************************************************************************/
+
+void MicroWait(uint16 timeout)
+{
+    (void)timeout;
+    simMatrixSettle();
+}
+
+uint8 OnBoard_SendKeys(uint8 keys, uint8 state)
+{
+    uint8 port = (state & HAL_KEY_PORT0) ? 0 : (state & HAL_KEY_PORT1) ? 1 : 2;
+
+    simKeyMsgs++;
+    simDeliver(port, keys);
+    return 0;
+}
+
+uint8 *osal_msg_allocate(uint16 len)
+{
+    return calloc(1, len);
+}
+
+uint8 osal_msg_deallocate(uint8 *msg)
+{
+    free(msg);
+    return 0;
+}
+
+uint8 osal_msg_send(uint8 destination_task, uint8 *msg)
+{
+    osal_event_hdr_t *hdr = (osal_event_hdr_t *)msg;
+    uint8 port, i;
+
+    (void)destination_task;
+    switch (hdr->event)
+    {
+    case HAL_KEY_BATCH_CHANGE:
+        simBatchMsgs++;
+        for (port = 0; port < 3; port++)
+            simDeliver(port, ((halKeyBatchChange_t *)msg)->changed[port]);
+        break;
+    case HAL_KEY_ENCODER_CHANGE:
+        simEncMsgs++;
+        break;
+    case HAL_KEY_COUNTER_REPORT:
+        simCntMsgs++;
+        break;
+    case HAL_KEY_MATRIX_CHANGE:
+        simMatrixMsgs++;
+        for (i = 0; i < simMatrixKeys; i++)
+            if (((halKeyMatrixChange_t *)msg)->changed & (1UL << i))
+                simDeliverKey(KEYSIM_MATRIX_PORT * 8 + i);
+        break;
+    default:
+        break;
+    }
+    free(msg);
+    return 0;
+}
+
+uint8 osal_start_timerEx(uint8 task_id, uint16 event_id, uint32 timeout_value)
+{
+    (void)task_id;
+    (void)event_id;
+    simDeadline = (int64_t)(simNow + (uint64_t)timeout_value * 1000);
+    return 0;
+}
+
+uint8 osal_stop_timerEx(uint8 task_id, uint16 event_id)
+{
+    (void)task_id;
+    (void)event_id;
+    simDeadline = -1;
+    return 0;
+}
+
+uint32 osal_get_timeoutEx(uint8 task_id, uint16 event_id)
+{
+    (void)task_id;
+    (void)event_id;
+    if (simDeadline < 0)
+        return 0;
+    return (uint32)(((uint64_t)simDeadline - simNow + 999) / 1000);
+}
+
+uint32 osal_GetSystemClock(void)
+{
+    return (uint32)(simNow / 1000);
+}
+
+void *osal_memset(void *dest, uint8 value, int len)
+{
+    return memset(dest, value, len);
+}
+
+void *osal_memcpy(void *dst, const void *src, unsigned int len)
+{
+    return memcpy(dst, src, len);
+}
+
+/**************************************************************************************************
+ *                                        FUNCTIONS - API
+ **************************************************************************************************/
+
+int main(int argc, char **argv)
+{
+    const char *trace = "all";
+    uint32 count = 20;
+    uint32 expected = 0, delivered = 0, dropped = 0, spurious = 0;
+    uint64_t t = 100000;
+    clock_t start;
+    double secs;
+    uint32 e;
+    uint8 port, i;
+    int opt;
+
+    for (opt = 1; opt < argc; opt++)
+    {
+        if (!strcmp(argv[opt], "-s") && opt + 1 < argc)
+            simSeed = (uint32)strtoul(argv[++opt], NULL, 0);
+        else if (!strcmp(argv[opt], "-n") && opt + 1 < argc)
+            count = (uint32)strtoul(argv[++opt], NULL, 0);
+        else if (argv[opt][0] == '-')
+        {
+            fprintf(stderr, "usage: %s [-s seed] [-n count] [bounce|burst|chatter|all|<trace file>]\n", argv[0]);
+            return 1;
+        }
+        else
+            trace = argv[opt];
+    }
+
+    // idle levels: pulled up for falling edge ports
+    for (port = 0; port < 3; port++)
+        *simPort(port) = simFallingEdge[port] ? 0xFF : 0x00;
+#ifdef HAL_KEY_MATRIX_ROW_PORT
+    for (i = 0; i < 8; i++)
+        for (port = 0; port < 8; port++)
+            if ((HAL_KEY_MATRIX_ROW_PINS & BV(i)) && (KEYSIM_MATRIX_COL_PINS & BV(port)))
+                simMatrixKeys++;
+#endif
+
+    HalKeyInit();
+    HalKeyConfig(TRUE, NULL);
+    simIfgSync();
+
+    if (!strcmp(trace, "bounce") || !strcmp(trace, "all"))
+        t = simGenBounce(t, count);
+    if (!strcmp(trace, "burst")) // drops events by design without HAL_KEY_BATCH
+        t = simGenBurst(t, count);
+    if (!strcmp(trace, "chatter") || !strcmp(trace, "all"))
+        t = simGenChatter(t, count);
+    if (!simEdgeCount && strcmp(trace, "bounce") && strcmp(trace, "burst") &&
+        strcmp(trace, "chatter") && strcmp(trace, "all") && simLoadTrace(trace))
+        return 1;
+
+    qsort(simEdges, simEdgeCount, sizeof(simEdge_t), simEdgeCmp);
+    simExpect();
+
+    start = clock();
+    for (e = 0; e < simEdgeCount; e++)
+    {
+        simRunUntil(simEdges[e].t);
+        simSetPin(simEdges[e].port, simEdges[e].pin, simEdges[e].level);
+    }
+    simRunUntil((simEdgeCount ? simEdges[simEdgeCount - 1].t : 0) + KEYSIM_TAIL_US);
+    secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    for (i = 0; i < KEYSIM_KEYS; i++)
+    {
+        expected += simExpected[i];
+        delivered += simDelivered[i];
+        if (simDelivered[i] < simExpected[i])
+            dropped += simExpected[i] - simDelivered[i];
+        else
+            spurious += simDelivered[i] - simExpected[i];
+    }
+
+    printf("trace          : %s, %u edges, %.3f s\n", trace, (unsigned)simEdgeCount, simNow / 1e6);
+    printf("isr calls      : P0 %u, P1 %u, P2 %u\n", (unsigned)simIsr[0], (unsigned)simIsr[1], (unsigned)simIsr[2]);
+    printf("polls          : %u\n", (unsigned)simPolls);
+    printf("key events     : expected %u, delivered %u, dropped %u, spurious %u\n",
+           (unsigned)expected, (unsigned)delivered, (unsigned)dropped, (unsigned)spurious);
+    printf("latency, us    : min %u, avg %u, max %u\n",
+           (unsigned)(simLatCount ? simLatMin : 0),
+           (unsigned)(simLatCount ? simLatSum / simLatCount : 0), (unsigned)simLatMax);
+    printf("messages       : key %u, batch %u, encoder %u, counter %u, matrix %u\n",
+           (unsigned)simKeyMsgs, (unsigned)simBatchMsgs, (unsigned)simEncMsgs, (unsigned)simCntMsgs,
+           (unsigned)simMatrixMsgs);
+    printf("host replay    : %.0f edges/s\n", secs > 0 ? simEdgeCount / secs : 0.0);
+
+    return dropped ? 2 : 0;
+}
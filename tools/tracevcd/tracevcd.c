@@ -0,0 +1,161 @@
+/**************************************************************************************************
+  Filename:       tracevcd.c
+
+  Revision:       20230128
+
+  Description:    Host decoder of HalTraceDump() output. Renders recorded GPIO transitions
+                  as Value Change Dump for waveform viewers.
+
+**************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/**************************************************************************************************
+ *                                              MACROS
+ **************************************************************************************************/
+
+#define TRACE_HDR_LEN    12
+#define TRACE_ENTRY_LEN  5
+#define TRACE_PORTS      3
+
+/* Entries sharing one timer tick are spaced that many ns apart to keep their order */
+#define TRACE_ORDER_NS   100
+
+/**************************************************************************************************
+ *                                         LOCAL VARIABLES
+ **************************************************************************************************/
+
+static uint8_t traceUsed[TRACE_PORTS];  // pins seen in any entry
+static uint8_t traceLevel[TRACE_PORTS]; // last dumped levels
+static uint8_t traceKnown[TRACE_PORTS]; // pins with dumped level
+
+/**************************************************************************************************
+ *                                         LOCAL FUNCTIONS
+ **************************************************************************************************/
+
+static unsigned readLe(const uint8_t *p, int len)
+{
+    unsigned v = 0;
+
+    while (len--)
+        v = (v << 8) | p[len];
+    return v;
+}
+
+static char vcdId(int port, int pin)
+{
+    return (char)('!' + port * 8 + pin);
+}
+
+static void vcdChanges(uint8_t port, uint8_t mask, uint8_t level)
+{
+    int pin;
+
+    for (pin = 0; pin < 8; pin++)
+    {
+        uint8_t bit = (uint8_t)(1 << pin);
+
+        if (!(mask & bit))
+            continue;
+        if ((traceKnown[port] & bit) && ((traceLevel[port] ^ level) & bit) == 0)
+            continue;
+        printf("%c%c\n", (level & bit) ? '1' : '0', vcdId(port, pin));
+        traceKnown[port] |= bit;
+        traceLevel[port] = (uint8_t)((traceLevel[port] & ~bit) | (level & bit));
+    }
+}
+
+/**************************************************************************************************
+ *                                              MAIN
+ **************************************************************************************************/
+
+int main(int argc, char **argv)
+{
+    FILE *in = stdin;
+    uint8_t hdr[TRACE_HDR_LEN];
+    uint8_t *data;
+    unsigned hz, entries, lost, entrySize, i;
+    unsigned long long ticks = 0, lastNs = 0, ns;
+    unsigned prevTime = 0;
+    int port, pin, first = 1;
+
+    if (argc > 2 || (argc == 2 && argv[1][0] == '-' && argv[1][1]))
+    {
+        fprintf(stderr, "usage: %s [dump file] > trace.vcd\n", argv[0]);
+        return 1;
+    }
+    if (argc == 2 && strcmp(argv[1], "-") && !(in = fopen(argv[1], "rb")))
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    if (fread(hdr, 1, TRACE_HDR_LEN, in) != TRACE_HDR_LEN || hdr[0] != 'G' || hdr[1] != 'T' || hdr[2] != 1)
+    {
+        fprintf(stderr, "not a trace dump\n");
+        return 1;
+    }
+    entrySize = hdr[3];
+    hz = readLe(hdr + 4, 4);
+    entries = readLe(hdr + 8, 2);
+    lost = readLe(hdr + 10, 2);
+    if (entrySize < TRACE_ENTRY_LEN || !hz)
+    {
+        fprintf(stderr, "unsupported trace format\n");
+        return 1;
+    }
+
+    data = malloc((size_t)entries * entrySize + 1);
+    if (!data || fread(data, entrySize, entries, in) != entries)
+    {
+        fprintf(stderr, "truncated trace dump\n");
+        return 1;
+    }
+
+    for (i = 0; i < entries; i++)
+    {
+        const uint8_t *e = data + i * entrySize;
+        if (e[2] < TRACE_PORTS)
+            traceUsed[e[2]] |= e[3];
+    }
+
+    printf("$comment %u entries, %u lost, %u Hz timestamps $end\n", entries, lost, hz);
+    printf("$timescale 1ns $end\n$scope module gpio $end\n");
+    for (port = 0; port < TRACE_PORTS; port++)
+        for (pin = 0; pin < 8; pin++)
+            if (traceUsed[port] & (1 << pin))
+                printf("$var wire 1 %c P%d_%d $end\n", vcdId(port, pin), port, pin);
+    printf("$upscope $end\n$enddefinitions $end\n");
+
+    for (i = 0; i < entries; i++)
+    {
+        const uint8_t *e = data + i * entrySize;
+        unsigned time = readLe(e, 2);
+
+        if (e[2] >= TRACE_PORTS)
+            continue;
+
+        // 16 bit timestamps, assumes less than one wrap between entries
+        if (!first)
+            ticks += (uint16_t)(time - prevTime);
+        prevTime = time;
+
+        ns = ticks * 1000000000ULL / hz;
+        if (!first && ns <= lastNs)
+            ns = lastNs + TRACE_ORDER_NS;
+        if (first || ns != lastNs)
+            printf("#%llu\n", ns);
+        first = 0;
+        lastNs = ns;
+
+        vcdChanges(e[2], e[3], e[4]);
+    }
+
+    free(data);
+    if (in != stdin)
+        fclose(in);
+    return 0;
+}